@@ -1,124 +1,156 @@
 #include "./parser.h"
 
-Parser::Parser(TokenList&& tokenList)
-{
-    tokens = std::move(tokenList);
-}
+#include <algorithm>
+#include <cctype>
+
+Parser::Parser(std::string_view input, size_t maxDepth)
+    :tokenizer{ input }, maxDepth{ maxDepth } {}
 
 ValuePtr Parser::parse()
 {
-    auto&& token = popNextToken();
-    switch (token->getType())
-    {
-    case TokenType::NUMERIC_LITERAL:
-    {
-        auto value = static_cast<NumericLiteralToken&>(*token).getValue();
-        return std::make_shared<NumericValue>(value);
-    }
-    case TokenType::BOOLEAN_LITERAL:
-    {
-        auto value = static_cast<BooleanLiteralToken&>(*token).getValue();
-        return std::make_shared<BooleanValue>(value);
-    }
-    case TokenType::CHAR_LITERAL:
-    {
-        auto value = static_cast<CharLiteralToken&>(*token).getValue();
-        return std::make_shared<CharValue>(value);
-    }
-    case TokenType::STRING_LITERAL:
-    {
-        auto& value = static_cast<StringLiteralToken&>(*token).getValue();
-        return std::make_shared<StringValue>(value);
-    }
-    case TokenType::IDENTIFIER:
-    {
-        auto& value = static_cast<IdentifierToken&>(*token).getName();
-        return std::make_shared<SymbolValue>(value);
-    }
-    case TokenType::LEFT_PAREN:
-    {
-        return parseListTails();
-    }
-    case TokenType::VECTOR_BEGIN:
-    {
-        return make_shared<VectorValue>(std::move(parseVectorTails()));
-    }
-    case TokenType::QUOTE:
-    case TokenType::QUASIQUOTE:
-    case TokenType::UNQUOTE:
-    case TokenType::UNQUOTE_SPLICING:
+    stack.clear();
+    while (true)
     {
-        return make_shared<PairValue>(substituteSymbol(token),make_shared<PairValue>(parse(),make_shared<NilValue>()));
-    }
-    default:
-        throw SyntaxError("Unimplemented");
-        break;
+        auto token = popNextToken();
+        ValuePtr value;
+        switch (token.type)
+        {
+        case TokenType::NUMERIC_LITERAL:
+        {
+            value = parseNumber(token.text);
+            break;
+        }
+        case TokenType::BOOLEAN_LITERAL:
+        {
+            value = std::make_shared<BooleanValue>(token.text == "#t");
+            break;
+        }
+        case TokenType::CHAR_LITERAL:
+        {
+            value = parseChar(token.text);
+            break;
+        }
+        case TokenType::STRING_LITERAL:
+        {
+            value = parseString(token.text);
+            break;
+        }
+        case TokenType::IDENTIFIER:
+        {
+            value = SymbolValue::intern(token.text);
+            break;
+        }
+        case TokenType::LEFT_PAREN:
+        {
+            pushFrame(Frame::Kind::List);
+            continue;
+        }
+        case TokenType::VECTOR_BEGIN:
+        {
+            pushFrame(Frame::Kind::Vector);
+            continue;
+        }
+        case TokenType::QUOTE:
+        case TokenType::QUASIQUOTE:
+        case TokenType::UNQUOTE:
+        case TokenType::UNQUOTE_SPLICING:
+        {
+            pushFrame(Frame::Kind::Quote, substituteSymbol(token));
+            continue;
+        }
+        case TokenType::DOT:
+        {
+            if (stack.empty() || stack.back().kind != Frame::Kind::List
+                || stack.back().list.isEmpty() || stack.back().rest != Frame::Rest::None)
+                throw SyntaxError("Unexpected dot");
+            stack.back().rest = Frame::Rest::Expected;
+            continue;
+        }
+        case TokenType::RIGHT_PAREN:
+        {
+            if (stack.empty() || stack.back().kind == Frame::Kind::Quote)
+                throw SyntaxError("Unexpected right paren");
+            value = closeFrame();
+            break;
+        }
+        default:
+            throw SyntaxError("Unimplemented");
+        }
+
+        // Hand the finished datum to the innermost open frame; quote frames complete as soon as they get one.
+        while (true)
+        {
+            if (stack.empty())
+                return value;
+            auto& top = stack.back();
+            if (top.kind == Frame::Kind::Quote)
+            {
+                value = make_shared<PairValue>(std::move(top.quoteSymbol), make_shared<PairValue>(std::move(value), make_shared<NilValue>()));
+                stack.pop_back();
+                continue;
+            }
+            if (top.kind == Frame::Kind::Vector)
+                top.elements.push_back(std::move(value));
+            else if (top.rest == Frame::Rest::None)
+                top.list.append(std::move(value));
+            else if (top.rest == Frame::Rest::Expected)
+            {
+                top.list.setRest(std::move(value));
+                top.rest = Frame::Rest::Read;
+            }
+            else
+                throw SyntaxError("Right paren expected");
+            break;
+        }
     }
-    return nullptr;
 }
 
-bool Parser::isEmpty() const
+bool Parser::isEmpty()
 {
-    return tokens.empty();
+    if (!lookahead)
+        lookahead = tokenizer.next();
+    return !lookahead;
 }
 
-TokenPtr Parser::popNextToken()
+Token Parser::popNextToken()
 {
-    if (tokens.empty())
-        throw SyntaxError("More token(s) expected");
-    auto nextToken = std::move(tokens.front());
-    tokens.pop_front();
-    return nextToken;
+    Token token = getNextToken();
+    lookahead.reset();
+    return token;
 }
 
-TokenPtr& Parser::getNextToken()
+const Token& Parser::getNextToken()
 {
-    if (tokens.empty())
+    if (isEmpty())
         throw SyntaxError("More token(s) expected");
-    return tokens.front();
+    return *lookahead;
 }
 
-ValuePtr Parser::parseListTails()
+void Parser::pushFrame(Frame::Kind kind, ValuePtr quoteSymbol)
 {
-    if (getNextToken()->getType() == TokenType::RIGHT_PAREN)
-    {
-        tokens.pop_front();
-        return make_shared<NilValue>();
-    }
-    auto car = parse();
-    ValuePtr cdr;
-    if (getNextToken()->getType() == TokenType::DOT)
-    {
-        tokens.pop_front();
-        cdr = parse();
-        if (getNextToken()->getType() != TokenType::RIGHT_PAREN)
-        {
-            throw SyntaxError("Right paren expected");
-        }
-        tokens.pop_front();
-    }
-    else
-    {
-        cdr = parseListTails();
-    }
-    return make_shared<PairValue>(car, cdr);
+    if (stack.size() >= maxDepth)
+        throw SyntaxError("Datum nested deeper than " + std::to_string(maxDepth) + " levels");
+    stack.push_back(Frame{ .kind = kind, .quoteSymbol = std::move(quoteSymbol) });
 }
 
-ValueList Parser::parseVectorTails()
+ValuePtr Parser::closeFrame()
 {
-    ValueList result;
-    while (getNextToken()->getType() != TokenType::RIGHT_PAREN)
-    {
-        result.push_back(parse());
-    }
-    tokens.pop_front();
-    return result;
+    auto& top = stack.back();
+    if (top.rest == Frame::Rest::Expected)
+        throw SyntaxError("Datum expected after dot");
+    ValuePtr value;
+    if (top.kind == Frame::Kind::Vector)
+        value = make_shared<VectorValue>(std::move(top.elements));
+    else
+        value = top.list.release();
+    stack.pop_back();
+    return value;
 }
 
-ValuePtr Parser::substituteSymbol(TokenPtr& token) const
+ValuePtr Parser::substituteSymbol(const Token& token) const
 {
     string name;
-    switch (token->getType())
+    switch (token.type)
     {
     case TokenType::QUOTE:
     {
@@ -144,5 +176,47 @@ ValuePtr Parser::substituteSymbol(TokenPtr& token) const
         name = "";
         break;
     }
-    return make_shared<SymbolValue>(name);
+    return SymbolValue::intern(name);
+}
+
+ValuePtr Parser::parseNumber(std::string_view text)
+{
+    auto value = Number::fromString(text);
+    if (!value)
+        throw SyntaxError("Invalid numeric literal " + string(text));
+    return make_shared<NumericValue>(std::move(*value));
+}
+
+ValuePtr Parser::parseChar(std::string_view text)
+{
+    auto equalsCi = [text](std::string_view name) {
+        return std::ranges::equal(text, name, [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+    };
+    if (text.empty() || equalsCi("space"))
+        return make_shared<CharValue>(' ');
+    else if (equalsCi("newline"))
+        return make_shared<CharValue>('\n');
+    else if (text.size() >= 2)
+        throw SyntaxError("Invalid character definition:" + string(text));
+    else
+        return make_shared<CharValue>(text[0]);
+}
+
+ValuePtr Parser::parseString(std::string_view text)
+{
+    string value;
+    value.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        if (text[i] == '\\' && i + 1 < text.size())
+        {
+            i++;
+            value += text[i] == 'n' ? '\n' : text[i];
+        }
+        else
+        {
+            value += text[i];
+        }
+    }
+    return make_shared<StringValue>(value);
 }
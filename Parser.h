@@ -1,30 +1,60 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include <deque>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 #include "./token.h"
+#include "./tokenizer.h"
 #include "./value.h"
 #include "./error.h"
 
-using std::deque, std::make_shared;
-
-using TokenList = deque<TokenPtr>;
+using std::make_shared;
 
+// Builds values straight from the tokenizer, pulling one token at a time, so no token list is ever
+// materialized. input must stay alive while the parser is in use.
+// Parsing keeps open lists on an explicit stack instead of the C++ call stack, so list length is
+// unbounded and nesting is limited only by maxDepth.
 class Parser
 {
-    TokenList tokens;
+    // A list, vector or quote-like prefix whose datum is still being read.
+    struct Frame
+    {
+        enum class Kind : uint8_t { List, Vector, Quote };
+        // For lists: whether a dot has been read, and whether the datum after it has too.
+        enum class Rest : uint8_t { None, Expected, Read };
+        Kind kind;
+        Rest rest = Rest::None;
+        ListBuilder list{};
+        ValueList elements{};
+        ValuePtr quoteSymbol;
+    };
+
+    Tokenizer tokenizer;
+    std::optional<Token> lookahead;
+    std::vector<Frame> stack;
+    size_t maxDepth;
 public:
-    Parser(TokenList&& tokenList);
+    static constexpr size_t DefaultMaxDepth = 1000;
+
+    Parser(std::string_view input, size_t maxDepth = DefaultMaxDepth);
+    // Parses the next datum. Throws SyntaxError if it nests deeper than maxDepth.
     ValuePtr parse();
-    bool isEmpty() const;
+    bool isEmpty();
 private:
-    TokenPtr popNextToken();
-    TokenPtr& getNextToken();
-    ValuePtr parseListTails();
-    ValueList parseVectorTails();
-    ValuePtr substituteSymbol(TokenPtr& token) const;
+    Token popNextToken();
+    const Token& getNextToken();
+    void pushFrame(Frame::Kind kind, ValuePtr quoteSymbol = nullptr);
+    ValuePtr closeFrame();
+    ValuePtr substituteSymbol(const Token& token) const;
+
+    static ValuePtr parseNumber(std::string_view text);
+    static ValuePtr parseChar(std::string_view text);
+    static ValuePtr parseString(std::string_view text);
 };
 
 #endif
@@ -1,5 +1,11 @@
 #include "./value.h"
 #include "./eval_env.h"
+#include "./printer.h"
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
 
 namespace ValueType
 {
@@ -33,6 +39,18 @@ namespace ValueType
             return "character";
         case VectorType:
             return "vector";
+        case F64VectorType:
+            return "f64vector";
+        case MatrixType:
+            return "matrix";
+        case BytevectorType:
+            return "bytevector";
+        case PortType:
+            return "port";
+        case EofType:
+            return "eof object";
+        case ErrorType:
+            return "error object";
         default:
             break;
         }
@@ -68,12 +86,17 @@ ValuePtr BooleanValue::copy() const
 
 bool NumericValue::isInteger() const
 {
-    return static_cast<long long>(dValue) == dValue;
+    return nValue.isInteger();
+}
+
+const Number& NumericValue::value() const
+{
+    return nValue;
 }
 
 string NumericValue::toString() const
 {
-    return isInteger() ? to_string(static_cast<int>(dValue)) : to_string(dValue);
+    return nValue.toString();
 }
 
 int NumericValue::getTypeID() const
@@ -83,42 +106,18 @@ int NumericValue::getTypeID() const
 
 optional<double> NumericValue::asNumber() const
 {
-    return dValue;
+    return nValue.toDouble();
 }
 
 ValuePtr NumericValue::copy() const
 {
-    return make_shared<NumericValue>(dValue);
+    return make_shared<NumericValue>(nValue);
 }
 
-string StringValue::escChars = { '\"', '\\' };
-
 string StringValue::toString() const
 {
-    vector<size_t> escPos;
-    string result = "\"";
-    for (size_t lastPos = 0; (lastPos = szValue.find_first_of(escChars, lastPos)) != string::npos; lastPos++)
-    {
-        escPos.push_back(lastPos);
-    }
-    for (size_t startPos = 0, i = 0, endPos = 0; i <= escPos.size(); i++)
-    {
-        if (i < escPos.size())
-        {
-            endPos = escPos[i];
-        }
-        else
-        {
-            endPos = szValue.size();
-        }
-        result += std::string_view(szValue.c_str() + startPos, endPos - startPos);
-        if (i < escPos.size())
-        {
-            result += "\\";
-            startPos = endPos;
-        }
-    }
-    result += "\"";
+    string result;
+    Printer::appendEscaped(result, szValue);
     return result;
 }
 
@@ -179,14 +178,36 @@ ValuePtr NilValue::copy() const
     return make_shared<NilValue>();
 }
 
-string NilValue::extractString(bool isOnRight) const
+string EofValue::toString() const
+{
+    return "#<eof>";
+}
+
+int EofValue::getTypeID() const
+{
+    return ValueType::EofType;
+}
+
+ValuePtr EofValue::copy() const
+{
+    return make_shared<EofValue>();
+}
+
+string ErrorValue::toString() const
 {
-    return isOnRight ? "" : "()";
+    // Named as the REPL reports an error that nothing caught.
+    static constexpr const char* kindNames[] = { "LispError", "SyntaxError", "InterpreterError" };
+    return "#<" + string(kindNames[static_cast<int>(errorKind)]) + ": " + errorMessage + ">";
 }
 
-string NilValue::extractDisplayString(bool isOnRight) const
+int ErrorValue::getTypeID() const
 {
-    return isOnRight ? "" : "()";
+    return ValueType::ErrorType;
+}
+
+ValuePtr ErrorValue::copy() const
+{
+    return make_shared<ErrorValue>(errorKind, errorMessage);
 }
 
 string SymbolValue::toString() const
@@ -209,14 +230,42 @@ ValuePtr SymbolValue::copy() const
     return make_shared<SymbolValue>(szSymbolName);
 }
 
+shared_ptr<SymbolValue> SymbolValue::intern(std::string_view name)
+{
+    // Transparent hash and equality let the table be probed with the view itself, so a repeated
+    // symbol costs no allocation at all.
+    struct Hash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+    // Files are parsed on several threads at once, so the table is split into shards with a lock each
+    // to keep them from queueing on one mutex. The shard is picked by a multiplicative mix of the hash,
+    // so the bucket choice inside a shard stays unbiased.
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<string, shared_ptr<SymbolValue>, Hash, std::equal_to<>> table;
+    };
+    constexpr int ShardBits = 6;
+    static std::array<Shard, size_t(1) << ShardBits> shards;
+    auto& [mutex, table] = shards[(uint64_t(Hash{}(name)) * 0x9E3779B97F4A7C15ull) >> (64 - ShardBits)];
+    std::lock_guard lock(mutex);
+    if (auto it = table.find(name); it != table.end())
+        return it->second;
+    auto symbol = make_shared<SymbolValue>(string(name));
+    table.emplace(string(name), symbol);
+    return symbol;
+}
+
 string PairValue::toString() const
 {
-    return '(' + extractString(false) + ')';
+    return Printer::toString(*this);
 }
 
 string PairValue::toDisplayString() const
 {
-    return '(' + extractDisplayString(false) + ')';
+    return Printer::toDisplayString(*this);
 }
 
 int PairValue::getTypeID() const
@@ -236,27 +285,36 @@ shared_ptr<ListValue> ListValue::fromDeque(deque<ValuePtr>& q)
 
 ValueList PairValue::toVector()
 {
-    if (!pRightValue->isType(ValueType::ListType))
-        throw LispError("Malformed list: expected pair or nil, got " + pRightValue->toString());
-    ValueList leftVector, rightVector = pRightValue->toVector();
-    leftVector.push_back(pLeftValue);
-    leftVector.insert(leftVector.end(), rightVector.begin(), rightVector.end());
-    return leftVector;
+    ValueList result;
+    const PairValue* pair = this;
+    while (true)
+    {
+        result.push_back(pair->pLeftValue);
+        if (!pair->pRightValue->isType(ValueType::PairType))
+            break;
+        pair = static_cast<const PairValue*>(pair->pRightValue.get());
+    }
+    if (!pair->pRightValue->isType(ValueType::NilType))
+        throw LispError("Malformed list: expected pair or nil, got " + pair->pRightValue->toString());
+    return result;
 }
 
-ValuePtr PairValue::left()
+const ValuePtr& PairValue::left() const
 {
     return pLeftValue;
 }
 
-ValuePtr PairValue::right()
+const ValuePtr& PairValue::right() const
 {
     return pRightValue;
 }
 
 bool PairValue::isList()
 {
-    return pRightValue->isType(ValueType::NilType) || pRightValue->isType(ValueType::PairType) && static_pointer_cast<PairValue>(pRightValue)->isList();
+    const PairValue* pair = this;
+    while (pair->pRightValue->isType(ValueType::PairType))
+        pair = static_cast<const PairValue*>(pair->pRightValue.get());
+    return pair->pRightValue->isType(ValueType::NilType);
 }
 
 ValuePtr PairValue::copy() const
@@ -264,14 +322,42 @@ ValuePtr PairValue::copy() const
     return make_shared<PairValue>(pLeftValue->copy(), pRightValue->copy());
 }
 
-string PairValue::extractString(bool isOnRight) const
+PairValue::~PairValue()
+{
+    // Detach each successor we hold the last reference to before it dies, so its destructor
+    // has no spine left to release recursively.
+    ValuePtr next = std::move(pRightValue);
+    while (next && next.use_count() == 1 && next->isType(ValueType::PairType))
+    {
+        auto pair = static_pointer_cast<PairValue>(std::move(next));
+        next = std::move(pair->pRightValue);
+    }
+}
+
+void ListBuilder::append(ValuePtr value)
+{
+    // The new last pair's cdr stays null until release() or setRest() terminates the list.
+    auto pair = make_shared<PairValue>(std::move(value), nullptr);
+    if (tail)
+        tail->pRightValue = pair;
+    else
+        head = pair;
+    tail = pair.get();
+}
+
+void ListBuilder::setRest(ValuePtr rest)
 {
-    return (isOnRight ? " " : "") + pLeftValue->toString() + pRightValue->extractString(true);
+    tail->pRightValue = std::move(rest);
 }
 
-string PairValue::extractDisplayString(bool isOnRight) const
+shared_ptr<ListValue> ListBuilder::release()
 {
-    return (isOnRight ? " " : "") + pLeftValue->toDisplayString() + pRightValue->extractDisplayString(true);
+    if (!head)
+        return make_shared<NilValue>();
+    if (!tail->pRightValue)
+        tail->pRightValue = make_shared<NilValue>();
+    tail = nullptr;
+    return std::move(head);
 }
 
 string Value::toDisplayString() const
@@ -304,18 +390,6 @@ Value::operator bool()
     return true;
 }
 
-string Value::extractString(bool isOnRight) const
-{
-    return (isOnRight ? " . " : "") + toString();
-}
-
-string Value::extractDisplayString(bool isOnRight) const
-{
-    return (isOnRight ? " . " : "") + toDisplayString();
-}
-
-const vector<int> CallableValue::UnlimitedType{ ValueType::AllType, CallableValue::SameToRest };
-
 ValuePtr CallableValue::call(const ValueList& args, EvalEnv& env)
 {
     checkValidParamCnt(args);
@@ -572,10 +646,49 @@ ValuePtr CharValue::copy() const
 
 string VectorValue::toString() const
 {
-    string result = "#(";
+    return Printer::toString(*this);
+}
+
+string VectorValue::toDisplayString() const
+{
+    return Printer::toDisplayString(*this);
+}
+
+int VectorValue::getTypeID() const
+{
+    return ValueType::VectorType;
+}
+
+vector<ValuePtr>& VectorValue::value()
+{
+    return vecValue;
+}
+
+const vector<ValuePtr>& VectorValue::value() const
+{
+    return vecValue;
+}
+
+ValuePtr& VectorValue::at(long long index)
+{
+    if (index < 0 || index >= vecValue.size())
+        throw LispError("Index " + to_string(index) + " out of range");
+    return vecValue[index];
+}
+
+ValuePtr VectorValue::copy() const
+{
+    ValueList result;
+    std::ranges::transform(vecValue, std::back_inserter(result), [](auto& a) {return a->copy(); });
+    return make_shared<VectorValue>(result);
+}
+
+string F64VectorValue::toString() const
+{
+    string result = "#f64(";
     for (size_t i = 0; i < vecValue.size(); i++)
     {
-        result += vecValue[i]->toString();
+        Number(vecValue[i]).appendTo(result);
         if (i != vecValue.size() - 1)
         {
             result += ' ';
@@ -585,13 +698,49 @@ string VectorValue::toString() const
     return result;
 }
 
-string VectorValue::toDisplayString() const
+int F64VectorValue::getTypeID() const
 {
-    string result = "#(";
-    for (size_t i = 0; i < vecValue.size(); i++)
+    return ValueType::F64VectorType;
+}
+
+vector<double>& F64VectorValue::value()
+{
+    return vecValue;
+}
+
+double& F64VectorValue::at(long long index)
+{
+    if (index < 0 || static_cast<size_t>(index) >= vecValue.size())
+        throw LispError("Index " + to_string(index) + " out of range");
+    return vecValue[index];
+}
+
+size_t F64VectorValue::size() const
+{
+    return vecValue.size();
+}
+
+ValuePtr F64VectorValue::copy() const
+{
+    return make_shared<F64VectorValue>(vector<double>(vecValue));
+}
+
+string MatrixValue::toString() const
+{
+    string result = "#matrix(";
+    for (size_t i = 0; i < rowCnt; i++)
     {
-        result += vecValue[i]->toDisplayString();
-        if (i != vecValue.size() - 1)
+        result += '(';
+        for (size_t j = 0; j < colCnt; j++)
+        {
+            Number(data[i * colCnt + j]).appendTo(result);
+            if (j != colCnt - 1)
+            {
+                result += ' ';
+            }
+        }
+        result += ')';
+        if (i != rowCnt - 1)
         {
             result += ' ';
         }
@@ -600,26 +749,88 @@ string VectorValue::toDisplayString() const
     return result;
 }
 
-int VectorValue::getTypeID() const
+int MatrixValue::getTypeID() const
 {
-    return ValueType::VectorType;
+    return ValueType::MatrixType;
 }
 
-vector<ValuePtr>& VectorValue::value()
+size_t MatrixValue::rows() const
 {
-    return vecValue;
+    return rowCnt;
 }
 
-ValuePtr& VectorValue::at(long long index)
+size_t MatrixValue::cols() const
 {
-    if (index < 0 || index >= vecValue.size())
+    return colCnt;
+}
+
+vector<double>& MatrixValue::value()
+{
+    return data;
+}
+
+double* MatrixValue::row(long long index)
+{
+    if (index < 0 || static_cast<size_t>(index) >= rowCnt)
+        throw LispError("Row " + to_string(index) + " out of range");
+    return data.data() + index * colCnt;
+}
+
+double& MatrixValue::at(long long rowIndex, long long colIndex)
+{
+    if (colIndex < 0 || static_cast<size_t>(colIndex) >= colCnt)
+        throw LispError("Column " + to_string(colIndex) + " out of range");
+    return row(rowIndex)[colIndex];
+}
+
+ValuePtr MatrixValue::copy() const
+{
+    return make_shared<MatrixValue>(rowCnt, colCnt, vector<double>(data));
+}
+
+string BytevectorValue::toString() const
+{
+    string result = "#u8(";
+    for (size_t i = 0; i < bytes.size(); i++)
+    {
+        result += to_string(bytes[i]);
+        if (i != bytes.size() - 1)
+        {
+            result += ' ';
+        }
+    }
+    result += ')';
+    return result;
+}
+
+int BytevectorValue::getTypeID() const
+{
+    return ValueType::BytevectorType;
+}
+
+vector<uint8_t>& BytevectorValue::value()
+{
+    return bytes;
+}
+
+uint8_t& BytevectorValue::at(long long index)
+{
+    return *range(index, 1);
+}
+
+uint8_t* BytevectorValue::range(long long index, size_t width)
+{
+    if (index < 0 || index + width > bytes.size())
         throw LispError("Index " + to_string(index) + " out of range");
-    return vecValue[index];
+    return bytes.data() + index;
 }
 
-ValuePtr VectorValue::copy() const
+size_t BytevectorValue::size() const
 {
-    ValueList result;
-    std::ranges::transform(vecValue, std::back_inserter(result), [](auto& a) {return a->copy(); });
-    return make_shared<VectorValue>(result);
+    return bytes.size();
+}
+
+ValuePtr BytevectorValue::copy() const
+{
+    return make_shared<BytevectorValue>(vector<uint8_t>(bytes));
 }
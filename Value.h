@@ -3,17 +3,21 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
 #include <deque>
 #include <stdexcept>
 #include <optional>
 #include <functional>
+#include <cstdint>
+#include <span>
 
 #include "./error.h"
+#include "./number.h"
 
 using std::ostream, std::endl, std::string, std::to_string, std::shared_ptr, std::vector,
-std::deque, std::out_of_range, std::enable_shared_from_this, std::optional, std::nullopt,
+std::deque, std::out_of_range, std::optional, std::nullopt,
 std::make_shared;
 
 class EvalEnv; // Defined in eval_env.h
@@ -33,12 +37,18 @@ namespace ValueType
     constexpr int PromiseType        = 0b0000001000000000;
     constexpr int CharType           = 0b0000010000000000;
     constexpr int VectorType         = 0b0000100000000000;
-    constexpr int SelfEvaluatingType = BooleanType | NumericType | StringType | BuiltinProcType | SpecialFormType | LambdaType | PromiseType | CharType;
+    constexpr int F64VectorType      = 0b0001000000000000;
+    constexpr int MatrixType         = 0b0010000000000000;
+    constexpr int BytevectorType     = 0b0100000000000000;
+    constexpr int PortType           = 0b1000000000000000;
+    constexpr int EofType            = 0b10000000000000000;
+    constexpr int ErrorType          = 0b100000000000000000;
+    constexpr int SelfEvaluatingType = BooleanType | NumericType | StringType | BuiltinProcType | SpecialFormType | LambdaType | PromiseType | CharType | F64VectorType | MatrixType | BytevectorType | PortType | EofType | ErrorType;
     constexpr int ListType           = NilType | PairType;
     constexpr int AtomType           = BooleanType | NumericType | StringType | SymbolType | NilType | CharType;
     constexpr int CallableType       = BuiltinProcType | SpecialFormType | LambdaType;
     constexpr int ProcedureType      = BuiltinProcType | LambdaType;
-    constexpr int AllType            = BooleanType | NumericType | StringType | NilType | SymbolType | PairType | BuiltinProcType | SpecialFormType | LambdaType | PromiseType | CharType | VectorType;
+    constexpr int AllType            = BooleanType | NumericType | StringType | NilType | SymbolType | PairType | BuiltinProcType | SpecialFormType | LambdaType | PromiseType | CharType | VectorType | F64VectorType | MatrixType | BytevectorType | PortType | EofType | ErrorType;
 
     string typeName(int typeID);
 };
@@ -50,10 +60,8 @@ using ReadOnlyValuePtr = shared_ptr<const Value>;
 using ValueList = vector<ValuePtr>;
 
 class Value
-    :public enable_shared_from_this<Value>
 {
     friend ostream& operator<<(ostream& os, const Value& thisValue);
-    friend class PairValue;
 public:
     virtual string toString() const = 0;
     virtual string toDisplayString() const;
@@ -65,9 +73,7 @@ public:
     explicit virtual operator bool();
     virtual ValuePtr copy() const = 0;
 protected:
-    Value() {}
-    virtual string extractString(bool isOnRight) const;
-    virtual string extractDisplayString(bool isOnRight) const;
+    constexpr Value() {}
     virtual ~Value() = default;
 };
 
@@ -87,13 +93,14 @@ public:
 class NumericValue
     :public Value
 {
-    double dValue;
+    Number nValue;
 public:
-    NumericValue(double d)
-        :dValue{ d } {}
+    NumericValue(Number n)
+        :nValue{ std::move(n) } {}
     string toString() const override;
     int getTypeID() const override;
     bool isInteger() const;
+    const Number& value() const;
     optional<double> asNumber() const override;
     ValuePtr copy() const override;
 };
@@ -116,10 +123,11 @@ class StringValue
     :public Value
 {
     string szValue;
-    static string escChars;
 public:
     StringValue(const string& s)
         :szValue{ s } {}
+    StringValue(string&& s)
+        :szValue{ std::move(s) } {}
     string toString() const override;
     string toDisplayString() const override;
     int getTypeID() const override;
@@ -149,9 +157,36 @@ public:
     ValueList toVector() override;
     bool isList() override;
     ValuePtr copy() const override;
-protected:
-    string extractString(bool isOnRight) const override;
-    string extractDisplayString(bool isOnRight) const override;
+};
+
+// What reading returns at the end of input.
+class EofValue
+    :public Value
+{
+public:
+    EofValue() = default;
+    string toString() const override;
+    int getTypeID() const override;
+    ValuePtr copy() const override;
+};
+
+// An error caught by guard: which kind of error it was, and its message.
+class ErrorValue
+    :public Value
+{
+public:
+    enum class Kind : uint8_t { Lisp, Syntax, Interpreter };
+private:
+    Kind errorKind;
+    string errorMessage;
+public:
+    ErrorValue(Kind kind, string message)
+        :errorKind{ kind }, errorMessage{ std::move(message) } {}
+    string toString() const override;
+    int getTypeID() const override;
+    ValuePtr copy() const override;
+    Kind kind() const { return errorKind; }
+    const string& message() const { return errorMessage; }
 };
 
 class VectorValue
@@ -167,10 +202,68 @@ public:
     string toDisplayString() const override;
     int getTypeID() const override;
     ValueList& value();
+    const ValueList& value() const;
     ValuePtr& at(long long index);
     ValuePtr copy() const override;
 };
 
+class F64VectorValue
+    :public Value
+{
+    vector<double> vecValue;
+public:
+    F64VectorValue(size_t size, double filler = 0)
+        :vecValue(size, filler) {}
+    F64VectorValue(vector<double>&& value)
+        :vecValue(std::move(value)) {}
+    string toString() const override;
+    int getTypeID() const override;
+    vector<double>& value();
+    double& at(long long index);
+    size_t size() const;
+    ValuePtr copy() const override;
+};
+
+class MatrixValue
+    :public Value
+{
+    size_t rowCnt;
+    size_t colCnt;
+    vector<double> data;
+public:
+    MatrixValue(size_t rows, size_t cols, double filler = 0)
+        :rowCnt{ rows }, colCnt{ cols }, data(rows * cols, filler) {}
+    MatrixValue(size_t rows, size_t cols, vector<double>&& value)
+        :rowCnt{ rows }, colCnt{ cols }, data(std::move(value)) {}
+    string toString() const override;
+    int getTypeID() const override;
+    size_t rows() const;
+    size_t cols() const;
+    vector<double>& value();
+    double* row(long long index);
+    double& at(long long rowIndex, long long colIndex);
+    ValuePtr copy() const override;
+};
+
+class BytevectorValue
+    :public Value
+{
+    vector<uint8_t> bytes;
+public:
+    BytevectorValue(size_t size, uint8_t filler = 0)
+        :bytes(size, filler) {}
+    BytevectorValue(vector<uint8_t>&& value)
+        :bytes(std::move(value)) {}
+    string toString() const override;
+    int getTypeID() const override;
+    vector<uint8_t>& value();
+    uint8_t& at(long long index);
+    // Pointer to `width` bytes starting at index, range checked.
+    uint8_t* range(long long index, size_t width);
+    size_t size() const;
+    ValuePtr copy() const override;
+};
+
 class SymbolValue
     :public Value
 {
@@ -178,6 +271,9 @@ class SymbolValue
 public:
     SymbolValue(const string& name)
         :szSymbolName{ name } {}
+    // Returns the shared instance for name, creating it on first use. Symbols are immutable,
+    // so the reader hands out one object per distinct name instead of allocating per occurrence.
+    static shared_ptr<SymbolValue> intern(std::string_view name);
     string toString() const override;
     int getTypeID() const override;
     optional<string> asSymbol() const override;
@@ -189,33 +285,46 @@ class PairValue
 {
     ValuePtr pLeftValue;
     ValuePtr pRightValue;
+    friend class ListBuilder;
+    friend class ImageReader;
 public:
     PairValue(ValuePtr pLeft, ValuePtr pRight)
         :pLeftValue{ pLeft }, pRightValue{ pRight } {}
+    // Frees the uniquely owned part of the spine in a loop, so dropping a long list cannot overflow the stack.
+    ~PairValue() override;
     string toString() const override;
     string toDisplayString() const override;
     int getTypeID() const override;
     ValueList toVector() override;
-    ValuePtr left();
-    ValuePtr right();
+    const ValuePtr& left() const;
+    const ValuePtr& right() const;
     bool isList() override;
     ValuePtr copy() const override;
-protected:
-    string extractString(bool isOnRight) const override;
-    string extractDisplayString(bool isOnRight) const override;
+};
+
+// Builds a list front to back by appending at the last pair, without recursion.
+class ListBuilder
+{
+    shared_ptr<PairValue> head;
+    PairValue* tail = nullptr;
+public:
+    bool isEmpty() const { return head == nullptr; }
+    void append(ValuePtr value);
+    // Ends the list with rest instead of nil, making it dotted. At least one element must have been appended.
+    void setRest(ValuePtr rest);
+    shared_ptr<ListValue> release();
 };
 
 template<typename Iter>
 shared_ptr<ListValue> createListFromIter(Iter begin, Iter end)
 {
-    if (begin == end)
-        return make_shared<NilValue>();
-    ValuePtr left = *begin;
-    return make_shared<PairValue>(left, createListFromIter(++begin, end));
+    ListBuilder builder;
+    for (; begin != end; ++begin)
+        builder.append(*begin);
+    return builder.release();
 }
 
-using FuncType = std::function<ValuePtr(const ValueList&, EvalEnv&)>;
-using FuncPtr = FuncType*;
+using FuncType = ValuePtr(*)(const ValueList&, EvalEnv&);
 
 /*
 class ParamChecker
@@ -242,12 +351,14 @@ protected:
     FuncType proc;
     int minParamCnt;
     int maxParamCnt;
-    vector<int> paramType;
+    std::span<const int> paramType;
 public:
     const static int UnlimitedCnt = -1;
     const static int SameToRest = 0;
-    const static vector<int> UnlimitedType;
-    CallableValue(FuncType procedure, int minArgs = UnlimitedCnt, int maxArgs = UnlimitedCnt, vector<int> type = UnlimitedType)
+    static constexpr std::span<const int> UnlimitedType{};
+    // Constant-constructible, so builtins and special forms can be built at compile time (registry.h).
+    // paramType must outlive the procedure.
+    constexpr CallableValue(FuncType procedure, int minArgs = UnlimitedCnt, int maxArgs = UnlimitedCnt, std::span<const int> type = UnlimitedType)
         :proc(procedure), minParamCnt(minArgs), maxParamCnt(maxArgs), paramType(type) {}
     virtual ValuePtr call(const ValueList& args, EvalEnv& env);
     static void assertParamCnt(const ValueList& params, int minArgs = UnlimitedCnt, int maxArgs = UnlimitedCnt);
@@ -283,6 +394,8 @@ class LambdaValue
     vector<string> paramNames;
     ValueList body;
     EnvPtr parentEnv;
+    friend class ImageWriter;
+    friend class ImageReader;
     static ValuePtr standardLambdaProc(const ValueList& params, EvalEnv& env);
 public:
     LambdaValue(const vector<string>& paramsDefinition, const ValueList& bodyDefinition, EnvPtr parentEvalEnv);
@@ -315,6 +428,8 @@ class PromiseValue
 {
     ValuePtr value;
     bool isEvaluated;
+    friend class ImageWriter;
+    friend class ImageReader;
 public:
     PromiseValue(ValuePtr value)
         :value{ value }, isEvaluated{ false } {}
@@ -0,0 +1,109 @@
+"""Matrix multiplication: matrix-mul against the same product written in Lisp over vectors of vectors.
+
+matrix-mul runs the blocked kernel over unboxed doubles; the Lisp version is the i-k-j triple loop
+on vectors of boxed numbers that matrix code was written as before there were matrices. Filling the
+inputs takes time of its own, so a script that only fills them is timed too, and the difference is
+reported as the multiply. The Lisp version does n^3 interpreted steps, so it is only run up to
+--naive-max; at 512 that is minutes a run, so lower it for a quick look.
+
+    python bench/matmul.py path/to/mini-lisp [--runs N] [--sizes N ...] [--naive-max N]
+"""
+
+import argparse
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+MATRIX_FILL = """
+(define n {n})
+(define (fill-matrix scale)
+  (let ((m (make-matrix n n)))
+    (do ((i 0 (+ i 1))) ((= i n) m)
+      (do ((j 0 (+ j 1))) ((= j n))
+        (matrix-set! m i j (* scale (+ i (* 2 j))))))))
+(define a (fill-matrix 0.001))
+(define b (fill-matrix 0.002))
+"""
+
+MATRIX_MUL = "(define c (matrix-mul a b))\n"
+
+NAIVE_FILL = """
+(define n {n})
+(define (fill-rows scale)
+  (let ((m (make-vector n)))
+    (do ((i 0 (+ i 1))) ((= i n) m)
+      (let ((row (make-vector n 0)))
+        (vector-set! m i row)
+        (do ((j 0 (+ j 1))) ((= j n))
+          (vector-set! row j (* scale (+ i (* 2 j)))))))))
+(define a (fill-rows 0.001))
+(define b (fill-rows 0.002))
+"""
+
+NAIVE_MUL = """
+(define (naive-mul a b)
+  (let ((c (make-vector n)))
+    (do ((i 0 (+ i 1))) ((= i n) c)
+      (let ((row (make-vector n 0))
+            (ai (vector-ref a i)))
+        (vector-set! c i row)
+        (do ((k 0 (+ k 1))) ((= k n))
+          (let ((aik (vector-ref ai k))
+                (bk (vector-ref b k)))
+            (do ((j 0 (+ j 1))) ((= j n))
+              (vector-set! row j (+ (vector-ref row j) (* aik (vector-ref bk j)))))))))))
+(define c (naive-mul a b))
+"""
+
+
+def run(command):
+    start = time.perf_counter()
+    subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+    return (time.perf_counter() - start) * 1000
+
+
+def write(directory, name, text):
+    path = os.path.join(directory, name)
+    with open(path, "w") as file:
+        file.write(text)
+    return path
+
+
+def multiply_time(binary, runs, fill, mul):
+    # The median of the fill alone is taken off the median of the fill and the multiply.
+    fills = [run([binary, fill]) for _ in range(runs)]
+    muls = [run([binary, mul]) for _ in range(runs)]
+    return statistics.median(muls) - statistics.median(fills)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("binary")
+    parser.add_argument("--runs", type=int, default=3)
+    parser.add_argument("--sizes", type=int, nargs="+", default=[512, 2048])
+    parser.add_argument("--naive-max", type=int, default=512)
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        for n in args.sizes:
+            matrix_fill = MATRIX_FILL.format(n=n)
+            fill = write(directory, "matrix_fill.scm", matrix_fill)
+            mul = write(directory, "matrix_mul.scm", matrix_fill + MATRIX_MUL)
+            run([args.binary, mul])  # warm the page cache
+            line = f"{n}x{n}, {args.runs} runs: matrix-mul {multiply_time(args.binary, args.runs, fill, mul):.0f} ms"
+
+            if n <= args.naive_max:
+                naive_fill = NAIVE_FILL.format(n=n)
+                fill = write(directory, "naive_fill.scm", naive_fill)
+                mul = write(directory, "naive_mul.scm", naive_fill + NAIVE_MUL)
+                line += f", Lisp vectors {multiply_time(args.binary, args.runs, fill, mul):.0f} ms"
+            else:
+                line += ", Lisp vectors skipped (above --naive-max)"
+            print(line)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
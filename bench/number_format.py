@@ -0,0 +1,75 @@
+"""Number formatting: printing 10^6 mixed numbers with write and with number->string.
+
+Printing numbers is most of the cost of emitting a large result list. The values are a mix of
+fixnums, integral flonums, doubles of ordinary size and doubles with large or small exponents, so
+both the integer path and the shortest-roundtrip path are covered. Reading the numbers takes time of
+its own, so a script that only reads them is timed too, and the difference is reported as the
+formatting. The number->string figure also includes the interpreted loop calling it, one step per
+number; write prints the whole vector in one call.
+
+    python bench/number_format.py path/to/mini-lisp [--runs N] [--count N]
+"""
+
+import argparse
+import os
+import random
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def numbers(count, seed=1):
+    rng = random.Random(seed)
+    for i in range(count):
+        kind = i % 4
+        if kind == 0:
+            yield str(rng.randint(-2 ** 62, 2 ** 62))
+        elif kind == 1:
+            yield repr(float(rng.randint(-10 ** 6, 10 ** 6)))
+        elif kind == 2:
+            yield repr(rng.uniform(-1e6, 1e6))
+        else:
+            yield repr(rng.uniform(1, 10) * 10.0 ** rng.randint(-300, 300))
+
+
+def run(command):
+    start = time.perf_counter()
+    subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+    return (time.perf_counter() - start) * 1000
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("binary")
+    parser.add_argument("--runs", type=int, default=3)
+    parser.add_argument("--count", type=int, default=10 ** 6)
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        data = "(define numbers '#(" + " ".join(numbers(args.count)) + "))\n"
+        scripts = {
+            "load": "",
+            "write": "(define text (with-output-to-string (lambda () (write numbers))))\n",
+            "number->string": "(define n (vector-length numbers))\n"
+                              "(do ((i 0 (+ i 1))) ((= i n)) (number->string (vector-ref numbers i)))\n",
+        }
+        paths = {}
+        for name, body in scripts.items():
+            paths[name] = os.path.join(directory, name.replace("->", "_to_") + ".scm")
+            with open(paths[name], "w") as file:
+                file.write(data)
+                file.write(body)
+
+        run([args.binary, paths["load"]])  # warm the page cache
+        times = {name: statistics.median(run([args.binary, path]) for _ in range(args.runs))
+                 for name, path in paths.items()}
+
+    print(f"{args.count} numbers, {args.runs} runs: read {times['load']:.0f} ms, "
+          f"write {times['write'] - times['load']:.0f} ms, "
+          f"number->string {times['number->string'] - times['load']:.0f} ms")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
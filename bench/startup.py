@@ -0,0 +1,46 @@
+"""Startup latency: wall time from launching mini-lisp to finishing an empty script.
+
+An empty script is done as soon as the interpreter is ready for its first form, so this tracks
+everything paid before the first eval: static initialization, the builtin tables, the global
+environment, and an image if one is given.
+
+    python bench/startup.py path/to/mini-lisp [--runs N] [-- extra arguments, e.g. --image prelude.img]
+"""
+
+import argparse
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("binary")
+    parser.add_argument("--runs", type=int, default=50)
+    argv = sys.argv[1:]
+    # Arguments after -- go to mini-lisp, before the script.
+    split = argv.index("--") if "--" in argv else len(argv)
+    args = parser.parse_args(argv[:split])
+    extra = argv[split + 1:]
+
+    with tempfile.TemporaryDirectory() as directory:
+        script = os.path.join(directory, "empty.scm")
+        open(script, "w").close()
+        command = [args.binary, *extra, script]
+
+        subprocess.run(command, check=True)  # warm the page cache
+        times = []
+        for _ in range(args.runs):
+            start = time.perf_counter()
+            subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+            times.append((time.perf_counter() - start) * 1000)
+
+    print(f"{args.runs} runs: min {min(times):.2f} ms, median {statistics.median(times):.2f} ms, "
+          f"max {max(times):.2f} ms")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,63 @@
+"""String comparison: sorting 10^6 strings with string-ci<?.
+
+Each comparison calls the builtin string-ci<? through sort, so this tracks the cost of a
+case-insensitive comparison and of calling a builtin. Reading the strings takes time of its own,
+so a script that only reads them is timed too, and the difference is reported as the sort.
+
+    python bench/string_sort.py path/to/mini-lisp [--runs N] [--count N]
+"""
+
+import argparse
+import os
+import random
+import statistics
+import string
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def words(count, seed=1):
+    # Mixed case, with common prefixes, so comparisons often run past the first few bytes.
+    rng = random.Random(seed)
+    prefixes = ["", "the", "THE", "Inter", "inter", "Mini-Lisp-"]
+    for _ in range(count):
+        body = "".join(rng.choice(string.ascii_letters) for _ in range(rng.randint(4, 20)))
+        yield rng.choice(prefixes) + body
+
+
+def run(command):
+    start = time.perf_counter()
+    subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+    return (time.perf_counter() - start) * 1000
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("binary")
+    parser.add_argument("--runs", type=int, default=3)
+    parser.add_argument("--count", type=int, default=10 ** 6)
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        data = "(define words '#(" + " ".join(f'"{word}"' for word in words(args.count)) + "))\n"
+        load = os.path.join(directory, "load.scm")
+        with open(load, "w") as file:
+            file.write(data)
+        sort = os.path.join(directory, "sort.scm")
+        with open(sort, "w") as file:
+            file.write(data)
+            file.write("(define sorted (sort words string-ci<?))\n")
+
+        run([args.binary, sort])  # warm the page cache
+        loads = [run([args.binary, load]) for _ in range(args.runs)]
+        sorts = [run([args.binary, sort]) for _ in range(args.runs)]
+
+    print(f"{args.count} strings, {args.runs} runs: read {statistics.median(loads):.0f} ms, "
+          f"read and sort {statistics.median(sorts):.0f} ms, "
+          f"sort {statistics.median(sorts) - statistics.median(loads):.0f} ms")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
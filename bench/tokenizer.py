@@ -0,0 +1,87 @@
+"""Tokenizer: reading 10^6 atoms that start like numbers but are mostly symbols.
+
+Every atom starting with a digit, +, - or . is first tried as a numeric literal, so source full of
+symbols such as -, +, ->string, ..., 1+ and -x is where a slow fallback from number to symbol shows.
+The atoms are quoted, so evaluating them costs next to nothing, and an empty script is timed too so
+that startup can be taken off. --save writes the generated source to a file, for profiling.
+
+    python bench/tokenizer.py path/to/mini-lisp [--runs N] [--count N] [--save FILE]
+"""
+
+import argparse
+import os
+import random
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+SYMBOLS = ["-", "+", "...", "->string", "->list", "-x", "+y", "1+", "1-", "-1+", ".foo", "+.", "-.",
+           "2d-array", "3rd", "+inf", "-nan", "1e", "1e+", "0x", "->"]
+
+
+def atoms(count, seed=1):
+    # Three symbols to every number, the numbers in the forms the literal grammar accepts.
+    rng = random.Random(seed)
+    for i in range(count):
+        if i % 4 != 3:
+            yield rng.choice(SYMBOLS)
+            continue
+        kind = rng.randrange(5)
+        if kind == 0:
+            yield str(rng.randint(-10 ** 9, 10 ** 9))
+        elif kind == 1:
+            yield repr(rng.uniform(-1e3, 1e3))
+        elif kind == 2:
+            yield f"{rng.uniform(1, 10):.3f}e{rng.randint(-30, 30)}"
+        elif kind == 3:
+            yield f"#x{rng.randrange(16 ** 8):x}"
+        else:
+            yield f"#b{rng.randrange(2 ** 16):b}"
+
+
+def source(count):
+    # Lines of twenty atoms, so the reader sees ordinary line lengths.
+    items = list(atoms(count))
+    lines = (" ".join(items[i:i + 20]) for i in range(0, len(items), 20))
+    return "(define atoms '(\n" + "\n".join(lines) + "))\n"
+
+
+def run(command):
+    start = time.perf_counter()
+    subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+    return (time.perf_counter() - start) * 1000
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("binary")
+    parser.add_argument("--runs", type=int, default=3)
+    parser.add_argument("--count", type=int, default=10 ** 6)
+    parser.add_argument("--save")
+    args = parser.parse_args()
+
+    text = source(args.count)
+    if args.save:
+        with open(args.save, "w") as file:
+            file.write(text)
+
+    with tempfile.TemporaryDirectory() as directory:
+        empty = os.path.join(directory, "empty.scm")
+        with open(empty, "w"):
+            pass
+        atoms_script = os.path.join(directory, "atoms.scm")
+        with open(atoms_script, "w") as file:
+            file.write(text)
+
+        run([args.binary, atoms_script])  # warm the page cache
+        starts = [run([args.binary, empty]) for _ in range(args.runs)]
+        reads = [run([args.binary, atoms_script]) for _ in range(args.runs)]
+
+    print(f"{args.count} atoms ({len(text) >> 10} KB), {args.runs} runs: "
+          f"read {statistics.median(reads) - statistics.median(starts):.0f} ms")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,434 @@
+#include "./bigint.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace
+{
+    using Limbs = std::vector<uint32_t>;
+    constexpr uint64_t Base = uint64_t(1) << 32;
+
+    void trimLimbs(Limbs& a)
+    {
+        while (!a.empty() && a.back() == 0)
+            a.pop_back();
+    }
+
+    int compareMagnitude(const Limbs& a, const Limbs& b)
+    {
+        if (a.size() != b.size())
+            return a.size() < b.size() ? -1 : 1;
+        for (size_t i = a.size(); i-- > 0;)
+        {
+            if (a[i] != b[i])
+                return a[i] < b[i] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    Limbs addMagnitude(const Limbs& a, const Limbs& b)
+    {
+        const Limbs& longer = a.size() >= b.size() ? a : b;
+        const Limbs& shorter = a.size() >= b.size() ? b : a;
+        Limbs result(longer.size() + 1);
+        uint64_t carry = 0;
+        for (size_t i = 0; i < longer.size(); i++)
+        {
+            uint64_t sum = carry + longer[i] + (i < shorter.size() ? shorter[i] : 0);
+            result[i] = static_cast<uint32_t>(sum);
+            carry = sum >> 32;
+        }
+        result[longer.size()] = static_cast<uint32_t>(carry);
+        trimLimbs(result);
+        return result;
+    }
+
+    // Requires |a| >= |b|.
+    Limbs subtractMagnitude(const Limbs& a, const Limbs& b)
+    {
+        Limbs result(a.size());
+        int64_t borrow = 0;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            int64_t diff = int64_t(a[i]) - borrow - (i < b.size() ? int64_t(b[i]) : 0);
+            borrow = diff < 0;
+            result[i] = static_cast<uint32_t>(diff + (borrow ? int64_t(Base) : 0));
+        }
+        trimLimbs(result);
+        return result;
+    }
+
+    // result[shift...] += x; result must be large enough to absorb the carry.
+    void addShifted(Limbs& result, const Limbs& x, size_t shift)
+    {
+        uint64_t carry = 0;
+        size_t i = 0;
+        for (; i < x.size(); i++)
+        {
+            uint64_t sum = carry + result[i + shift] + x[i];
+            result[i + shift] = static_cast<uint32_t>(sum);
+            carry = sum >> 32;
+        }
+        for (; carry != 0; i++)
+        {
+            uint64_t sum = carry + result[i + shift];
+            result[i + shift] = static_cast<uint32_t>(sum);
+            carry = sum >> 32;
+        }
+    }
+
+    Limbs multiplySchoolbook(const Limbs& a, const Limbs& b)
+    {
+        Limbs result(a.size() + b.size());
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < b.size(); j++)
+            {
+                uint64_t product = uint64_t(a[i]) * b[j] + result[i + j] + carry;
+                result[i + j] = static_cast<uint32_t>(product);
+                carry = product >> 32;
+            }
+            result[i + b.size()] = static_cast<uint32_t>(carry);
+        }
+        trimLimbs(result);
+        return result;
+    }
+
+    Limbs multiplyMagnitude(const Limbs& a, const Limbs& b)
+    {
+        if (a.empty() || b.empty())
+            return {};
+        if (std::min(a.size(), b.size()) < BigInt::KaratsubaThreshold)
+            return multiplySchoolbook(a, b);
+        // a = a1 * B^half + a0, b = b1 * B^half + b0
+        size_t half = std::max(a.size(), b.size()) / 2;
+        auto split = [half](const Limbs& x) {
+            Limbs low(x.begin(), x.begin() + std::min(half, x.size()));
+            Limbs high(x.begin() + std::min(half, x.size()), x.end());
+            trimLimbs(low);
+            return std::make_pair(low, high);
+        };
+        auto [a0, a1] = split(a);
+        auto [b0, b1] = split(b);
+        Limbs z0 = multiplyMagnitude(a0, b0);
+        Limbs z2 = multiplyMagnitude(a1, b1);
+        Limbs z1 = multiplyMagnitude(addMagnitude(a0, a1), addMagnitude(b0, b1));
+        z1 = subtractMagnitude(subtractMagnitude(z1, z0), z2);
+        Limbs result(a.size() + b.size() + 1);
+        addShifted(result, z0, 0);
+        addShifted(result, z1, half);
+        addShifted(result, z2, 2 * half);
+        trimLimbs(result);
+        return result;
+    }
+
+    // Divides in place by a single limb and returns the remainder.
+    uint32_t divideSmall(Limbs& a, uint32_t divisor)
+    {
+        uint64_t remainder = 0;
+        for (size_t i = a.size(); i-- > 0;)
+        {
+            uint64_t current = (remainder << 32) | a[i];
+            a[i] = static_cast<uint32_t>(current / divisor);
+            remainder = current % divisor;
+        }
+        trimLimbs(a);
+        return static_cast<uint32_t>(remainder);
+    }
+
+    void multiplyAddSmall(Limbs& a, uint32_t factor, uint32_t addend)
+    {
+        uint64_t carry = addend;
+        for (auto& limb : a)
+        {
+            uint64_t product = uint64_t(limb) * factor + carry;
+            limb = static_cast<uint32_t>(product);
+            carry = product >> 32;
+        }
+        if (carry != 0)
+            a.push_back(static_cast<uint32_t>(carry));
+    }
+
+    // Knuth, TAOCP vol. 2, 4.3.1 Algorithm D. Requires v.size() >= 2 and |u| >= |v|.
+    std::pair<Limbs, Limbs> divideKnuth(const Limbs& u, const Limbs& v)
+    {
+        size_t n = v.size(), m = u.size();
+        int shift = std::countl_zero(v.back());
+        Limbs vn(n), un(m + 1);
+        for (size_t i = n - 1; i > 0; i--)
+            vn[i] = (v[i] << shift) | (shift ? v[i - 1] >> (32 - shift) : 0);
+        vn[0] = v[0] << shift;
+        un[m] = shift ? u[m - 1] >> (32 - shift) : 0;
+        for (size_t i = m - 1; i > 0; i--)
+            un[i] = (u[i] << shift) | (shift ? u[i - 1] >> (32 - shift) : 0);
+        un[0] = u[0] << shift;
+
+        Limbs q(m - n + 1);
+        for (size_t j = m - n + 1; j-- > 0;)
+        {
+            uint64_t numerator = (uint64_t(un[j + n]) << 32) | un[j + n - 1];
+            uint64_t qhat = numerator / vn[n - 1];
+            uint64_t rhat = numerator % vn[n - 1];
+            while (qhat >= Base || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2]))
+            {
+                qhat--;
+                rhat += vn[n - 1];
+                if (rhat >= Base)
+                    break;
+            }
+            int64_t borrow = 0, t = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                uint64_t product = qhat * vn[i];
+                t = int64_t(un[i + j]) - borrow - int64_t(product & 0xFFFFFFFF);
+                un[i + j] = static_cast<uint32_t>(t);
+                borrow = int64_t(product >> 32) - (t >> 32);
+            }
+            t = int64_t(un[j + n]) - borrow;
+            un[j + n] = static_cast<uint32_t>(t);
+            q[j] = static_cast<uint32_t>(qhat);
+            if (t < 0)
+            {
+                q[j]--;
+                uint64_t carry = 0;
+                for (size_t i = 0; i < n; i++)
+                {
+                    uint64_t sum = uint64_t(un[i + j]) + vn[i] + carry;
+                    un[i + j] = static_cast<uint32_t>(sum);
+                    carry = sum >> 32;
+                }
+                un[j + n] = static_cast<uint32_t>(un[j + n] + carry);
+            }
+        }
+
+        Limbs r(n);
+        for (size_t i = 0; i < n; i++)
+            r[i] = (un[i] >> shift) | (shift ? un[i + 1] << (32 - shift) : 0);
+        trimLimbs(q);
+        trimLimbs(r);
+        return { q, r };
+    }
+
+    int digitValue(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'z')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'Z')
+            return c - 'A' + 10;
+        return 36;
+    }
+
+    // Largest power of radix that fits in a limb, and its exponent.
+    std::pair<uint32_t, int> radixChunk(int radix)
+    {
+        uint64_t chunk = radix;
+        int digits = 1;
+        while (chunk * radix < Base)
+        {
+            chunk *= radix;
+            digits++;
+        }
+        return { static_cast<uint32_t>(chunk), digits };
+    }
+}
+
+BigInt::BigInt(long long value)
+    :negative{ value < 0 }
+{
+    uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    while (magnitude != 0)
+    {
+        limbs.push_back(static_cast<uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+void BigInt::trim()
+{
+    trimLimbs(limbs);
+    if (limbs.empty())
+        negative = false;
+}
+
+std::optional<BigInt> BigInt::fromString(std::string_view text, int radix)
+{
+    BigInt result;
+    bool isNegative = false;
+    if (!text.empty() && (text[0] == '+' || text[0] == '-'))
+    {
+        isNegative = text[0] == '-';
+        text.remove_prefix(1);
+    }
+    if (text.empty() || radix < 2 || radix > 36)
+        return std::nullopt;
+    auto [chunk, chunkDigits] = radixChunk(radix);
+    for (size_t pos = 0; pos < text.size();)
+    {
+        uint32_t factor = 1, addend = 0;
+        for (int i = 0; i < chunkDigits && pos < text.size(); i++, pos++)
+        {
+            int digit = digitValue(text[pos]);
+            if (digit >= radix)
+                return std::nullopt;
+            factor *= radix;
+            addend = addend * radix + digit;
+        }
+        multiplyAddSmall(result.limbs, factor, addend);
+    }
+    result.negative = isNegative;
+    result.trim();
+    return result;
+}
+
+bool BigInt::isZero() const
+{
+    return limbs.empty();
+}
+
+bool BigInt::isNegative() const
+{
+    return negative;
+}
+
+bool BigInt::isOdd() const
+{
+    return !limbs.empty() && (limbs[0] & 1);
+}
+
+bool BigInt::fitsInt64() const
+{
+    if (limbs.size() > 2)
+        return false;
+    uint64_t magnitude = limbs.empty() ? 0 : limbs[0] | (limbs.size() > 1 ? uint64_t(limbs[1]) << 32 : 0);
+    return negative ? magnitude <= uint64_t(1) << 63 : magnitude < uint64_t(1) << 63;
+}
+
+long long BigInt::toInt64() const
+{
+    uint64_t magnitude = limbs.empty() ? 0 : limbs[0] | (limbs.size() > 1 ? uint64_t(limbs[1]) << 32 : 0);
+    return static_cast<long long>(negative ? 0 - magnitude : magnitude);
+}
+
+double BigInt::toDouble() const
+{
+    // The top three limbs carry more than the 53 significant bits a double can hold.
+    double result = 0;
+    size_t used = std::min<size_t>(limbs.size(), 3);
+    for (size_t i = 0; i < used; i++)
+        result = result * double(Base) + limbs[limbs.size() - 1 - i];
+    result = std::ldexp(result, static_cast<int>(32 * (limbs.size() - used)));
+    return negative ? -result : result;
+}
+
+std::string BigInt::toString(int radix) const
+{
+    if (limbs.empty())
+        return "0";
+    static constexpr char digitChars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    auto [chunk, chunkDigits] = radixChunk(radix);
+    Limbs rest = limbs;
+    std::string reversed;
+    while (!rest.empty())
+    {
+        uint32_t part = divideSmall(rest, chunk);
+        for (int i = 0; i < chunkDigits && (part != 0 || !rest.empty()); i++)
+        {
+            reversed += digitChars[part % radix];
+            part /= radix;
+        }
+    }
+    if (negative)
+        reversed += '-';
+    return std::string(reversed.rbegin(), reversed.rend());
+}
+
+BigInt BigInt::operator-() const
+{
+    BigInt result = *this;
+    result.negative = !negative;
+    result.trim();
+    return result;
+}
+
+BigInt BigInt::abs() const
+{
+    BigInt result = *this;
+    result.negative = false;
+    return result;
+}
+
+BigInt operator+(const BigInt& lhs, const BigInt& rhs)
+{
+    BigInt result;
+    if (lhs.negative == rhs.negative)
+    {
+        result.limbs = addMagnitude(lhs.limbs, rhs.limbs);
+        result.negative = lhs.negative;
+    }
+    else if (compareMagnitude(lhs.limbs, rhs.limbs) >= 0)
+    {
+        result.limbs = subtractMagnitude(lhs.limbs, rhs.limbs);
+        result.negative = lhs.negative;
+    }
+    else
+    {
+        result.limbs = subtractMagnitude(rhs.limbs, lhs.limbs);
+        result.negative = rhs.negative;
+    }
+    result.trim();
+    return result;
+}
+
+BigInt operator-(const BigInt& lhs, const BigInt& rhs)
+{
+    return lhs + (-rhs);
+}
+
+BigInt operator*(const BigInt& lhs, const BigInt& rhs)
+{
+    BigInt result;
+    result.limbs = multiplyMagnitude(lhs.limbs, rhs.limbs);
+    result.negative = lhs.negative != rhs.negative;
+    result.trim();
+    return result;
+}
+
+std::pair<BigInt, BigInt> BigInt::divMod(const BigInt& lhs, const BigInt& rhs)
+{
+    BigInt quotient, remainder;
+    if (compareMagnitude(lhs.limbs, rhs.limbs) < 0)
+    {
+        remainder = lhs;
+        return { quotient, remainder };
+    }
+    if (rhs.limbs.size() == 1)
+    {
+        quotient.limbs = lhs.limbs;
+        uint32_t small = divideSmall(quotient.limbs, rhs.limbs[0]);
+        if (small != 0)
+            remainder.limbs.push_back(small);
+    }
+    else
+    {
+        auto [q, r] = divideKnuth(lhs.limbs, rhs.limbs);
+        quotient.limbs = std::move(q);
+        remainder.limbs = std::move(r);
+    }
+    quotient.negative = lhs.negative != rhs.negative;
+    remainder.negative = lhs.negative;
+    quotient.trim();
+    remainder.trim();
+    return { quotient, remainder };
+}
+
+int BigInt::compare(const BigInt& lhs, const BigInt& rhs)
+{
+    if (lhs.negative != rhs.negative)
+        return lhs.negative ? -1 : 1;
+    int result = compareMagnitude(lhs.limbs, rhs.limbs);
+    return lhs.negative ? -result : result;
+}
@@ -0,0 +1,44 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <utility>
+
+// Arbitrary-precision signed integer, stored as sign and magnitude in base 2^32 limbs (least significant first).
+class BigInt
+{
+    bool negative = false;
+    std::vector<uint32_t> limbs;
+
+    void trim();
+public:
+    // Operand size (in limbs) above which multiplication switches from schoolbook to Karatsuba.
+    static constexpr size_t KaratsubaThreshold = 32;
+
+    BigInt() = default;
+    BigInt(long long value);
+    static std::optional<BigInt> fromString(std::string_view text, int radix = 10);
+
+    bool isZero() const;
+    bool isNegative() const;
+    bool isOdd() const;
+    bool fitsInt64() const;
+    long long toInt64() const;
+    double toDouble() const;
+    std::string toString(int radix = 10) const;
+
+    BigInt operator-() const;
+    BigInt abs() const;
+    friend BigInt operator+(const BigInt& lhs, const BigInt& rhs);
+    friend BigInt operator-(const BigInt& lhs, const BigInt& rhs);
+    friend BigInt operator*(const BigInt& lhs, const BigInt& rhs);
+    // Truncating division, like C++ integer / and %. Divisor must be non-zero.
+    static std::pair<BigInt, BigInt> divMod(const BigInt& lhs, const BigInt& rhs);
+    static int compare(const BigInt& lhs, const BigInt& rhs);
+};
+
+#endif // !BIGINT_H
@@ -1,5 +1,15 @@
 #include "./builtins.h"
 #include "./eval_env.h"
+#include "./fasl.h"
+#include "./image.h"
+#include "./port.h"
+#include "./registry.h"
+#include "./simd.h"
+
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 
 using namespace std::literals;
 using std::make_pair;
@@ -8,41 +18,143 @@ namespace Builtin
 {
     namespace Helper
     {
-        pair<string, shared_ptr<BuiltinProcValue>> BuiltinItem(string name, FuncType func, int minArgs, int maxArgs, const vector<int>& paramType)
+        bool CiString::operator==(const CiString& other) const
         {
-            return make_pair(name, make_shared<BuiltinProcValue>(func, minArgs, maxArgs, paramType));
+            return text.size() == other.text.size() && Simd::compareFolded(text.data(), other.text.data(), text.size()) == 0;
         }
 
-        double numberConv(ValuePtr value)
+        std::strong_ordering CiString::operator<=>(const CiString& other) const
         {
-            return *value->asNumber();
+            // Ordered like std::string, on unsigned bytes, with a prefix before the longer string.
+            int result = Simd::compareFolded(text.data(), other.text.data(), std::min(text.size(), other.text.size()));
+            if (result != 0)
+                return result <=> 0;
+            return text.size() <=> other.text.size();
         }
 
-        string stringConv(ValuePtr value)
+        Number numberConv(const ValuePtr& value)
         {
-            return std::dynamic_pointer_cast<StringValue>(value)->value();
+            return std::static_pointer_cast<NumericValue>(value)->value();
         }
 
-        string stringCiConv(ValuePtr value)
+        const string& stringConv(const ValuePtr& value)
         {
-            return ci(stringConv(value));
+            return static_cast<const StringValue&>(*value).value();
         }
 
-        char charConv(ValuePtr value)
+        std::string_view stringViewConv(const ValuePtr& value)
         {
-            return std::dynamic_pointer_cast<CharValue>(value)->value();
+            return static_cast<const StringValue&>(*value).value();
         }
 
-        char charCiConv(ValuePtr value)
+        size_t startConv(const ValueList& params, size_t index, size_t size)
         {
-            return std::tolower(std::dynamic_pointer_cast<CharValue>(value)->value());
+            if (params.size() <= index)
+                return 0;
+            auto n = std::dynamic_pointer_cast<NumericValue>(params[index]);
+            if (!n || !n->isInteger() || *n->asNumber() < 0 || *n->asNumber() > size)
+                throw LispError(params[index]->toString() + " is not a valid start index");
+            return static_cast<size_t>(*n->asNumber());
         }
 
-        string ci(const string& s)
+        // A found index as a value, or #f for npos.
+        ValuePtr indexOrFalse(size_t index)
         {
-            string result;
-            std::ranges::transform(s, std::back_inserter(result), std::tolower);
-            return result;
+            if (index == std::string_view::npos)
+                return make_shared<BooleanValue>(false);
+            return make_shared<NumericValue>(Number(static_cast<long long>(index)));
+        }
+
+        // The first occurrence of pattern in text at or after start, or npos.
+        size_t search(std::string_view text, std::string_view pattern, size_t start)
+        {
+            if (pattern.empty())
+                return start;
+            size_t index = Simd::search(text.data(), start, text.size(), pattern.data(), pattern.size());
+            return index == text.size() ? std::string_view::npos : index;
+        }
+
+        CiString stringCiConv(const ValuePtr& value)
+        {
+            return { stringViewConv(value) };
+        }
+
+        char charConv(const ValuePtr& value)
+        {
+            return static_cast<const CharValue&>(*value).value();
+        }
+
+        char charCiConv(const ValuePtr& value)
+        {
+            return Simd::foldCase(charConv(value));
+        }
+
+        ValuePtr printLimit(const ValueList& params, size_t& limit)
+        {
+            if (params.empty())
+            {
+                if (limit == SIZE_MAX)
+                    return make_shared<BooleanValue>(false);
+                return make_shared<NumericValue>(Number(static_cast<long long>(limit)));
+            }
+            if (params[0]->isType(ValueType::BooleanType) && !*params[0])
+            {
+                limit = SIZE_MAX;
+                return make_shared<NilValue>();
+            }
+            auto n = std::dynamic_pointer_cast<NumericValue>(params[0]);
+            if (!n || !n->isInteger() || *n->asNumber() < 0)
+                throw LispError(params[0]->toString() + " is not a non-negative integer or #f");
+            limit = static_cast<size_t>(*n->asNumber());
+            return make_shared<NilValue>();
+        }
+
+        OutputPort& outputPortConv(const ValueList& params, size_t index)
+        {
+            if (params.size() <= index)
+                return currentOutputPort();
+            auto port = static_pointer_cast<PortValue>(params[index])->output();
+            if (!port)
+                throw LispError(params[index]->toString() + " is not an output port");
+            if (!port->isOpen())
+                throw LispError(params[index]->toString() + " is closed");
+            return *port;
+        }
+
+        InputPort& inputPortConv(const ValueList& params, size_t index)
+        {
+            if (params.size() <= index)
+                return *currentInputPortPtr();
+            auto port = static_pointer_cast<PortValue>(params[index])->input();
+            if (!port)
+                throw LispError(params[index]->toString() + " is not an input port");
+            if (!port->isOpen())
+                throw LispError(params[index]->toString() + " is closed");
+            return *port;
+        }
+
+        // Sets value to a string holding text. The string is reused if nothing else refers to it any more,
+        // so its storage is too; otherwise, say when a callback kept it, a new one is made.
+        void reuseString(shared_ptr<StringValue>& value, std::string_view text)
+        {
+            if (value && value.use_count() == 1)
+                value->value().assign(text);
+            else
+                value = make_shared<StringValue>(string(text));
+        }
+
+        // A character read from a port, or the end of file object.
+        ValuePtr charOrEof(std::optional<char> c)
+        {
+            if (!c)
+                return make_shared<EofValue>();
+            return make_shared<CharValue>(*c);
+        }
+
+        // Whether display was called as (display obj port).
+        bool isDisplayToPort(const ValueList& params)
+        {
+            return params.size() == 2 && params[1]->isType(ValueType::PortType);
         }
     }
 
@@ -53,25 +165,45 @@ namespace Builtin
             return env.apply(params[0], params[1]);
         }
 
+        ValuePtr compileFile(const ValueList& params, EvalEnv& env)
+        {
+            Fasl::compile(stringConv(params[0]));
+            return make_shared<NilValue>();
+        }
+
         ValuePtr print(const ValueList& params, EvalEnv& env)
         {
+            auto& port = currentOutputPort();
             for (auto& p : params)
-                cout << p->toString() << endl;
+            {
+                port.print(*p, false);
+                port.put('\n');
+            }
             return make_shared<NilValue>();
         }
 
         ValuePtr display(const ValueList& params, EvalEnv& env)
         {
+            // Given a port, display writes just the value there, so text can be built up piece by piece;
+            // otherwise each value goes on a line of its own.
+            if (isDisplayToPort(params))
+            {
+                outputPortConv(params, 1).print(*params[0], true);
+                return make_shared<NilValue>();
+            }
+            auto& port = currentOutputPort();
             for (auto& p : params)
             {
-                cout << p->toDisplayString() << endl;
+                port.print(*p, true);
+                port.put('\n');
             }
             return make_shared<NilValue>();
         }
 
         ValuePtr displayln(const ValueList& params, EvalEnv& env)
         {
-            return display(params, env), newline(params, env);
+            display(params, env);
+            return newline(isDisplayToPort(params) ? ValueList{ params[1] } : ValueList{}, env);
         }
 
         ValuePtr error(const ValueList& params, EvalEnv& env)
@@ -79,6 +211,11 @@ namespace Builtin
             throw LispError(params[0]->toString());
         }
 
+        ValuePtr errorObjectMessage(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<StringValue>(static_cast<const ErrorValue&>(*params[0]).message());
+        }
+
         ValuePtr eval(const ValueList& params, EvalEnv& env)
         {
             return env.eval(params[0]);
@@ -96,16 +233,242 @@ namespace Builtin
             throw ExitEvent(exitCode);
         }
 
+        ValuePtr flushOutput(const ValueList& params, EvalEnv& env)
+        {
+            currentOutputPort().flush();
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr load(const ValueList& params, EvalEnv& env)
+        {
+            // Read as a script run from the command line is, from a fresh FASL cache if there is one, and
+            // run at top level wherever load is called from.
+            auto& global = env.global();
+            auto forms = Fasl::openForms(stringConv(params[0]));
+            while (auto value = forms->next())
+                global.eval(std::move(value));
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr loadImage(const ValueList& params, EvalEnv& env)
+        {
+            Image::load(env.global(), stringConv(params[0]));
+            return make_shared<NilValue>();
+        }
+
         ValuePtr newline(const ValueList& params, EvalEnv& env)
         {
-            cout << endl;
+            outputPortConv(params, 0).put('\n');
             return make_shared<NilValue>();
         }
 
+        ValuePtr printDepth(const ValueList& params, EvalEnv& env)
+        {
+            return printLimit(params, OutputPort::printDepth);
+        }
+
+        ValuePtr printLength(const ValueList& params, EvalEnv& env)
+        {
+            return printLimit(params, OutputPort::printLength);
+        }
+
         ValuePtr read(const ValueList& params, EvalEnv& env)
         {
+            if (!params.empty())
+            {
+                auto value = inputPortConv(params, 0).read();
+                return value ? value : make_shared<EofValue>();
+            }
+            // A prompt written before the read has to be on screen while the user types.
+            currentOutputPort().flush();
             return stdinReader->read();
         }
+
+        ValuePtr isReadError(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<BooleanValue>(params[0]->isType(ValueType::ErrorType)
+                && static_cast<const ErrorValue&>(*params[0]).kind() == ErrorValue::Kind::Syntax);
+        }
+
+        ValuePtr saveImage(const ValueList& params, EvalEnv& env)
+        {
+            Image::save(env, stringConv(params[0]));
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr write(const ValueList& params, EvalEnv& env)
+        {
+            outputPortConv(params, 1).print(*params[0], false);
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr writeShared(const ValueList& params, EvalEnv& env)
+        {
+            outputPortConv(params, 1).print(*params[0], false, true);
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr writeString(const ValueList& params, EvalEnv& env)
+        {
+            outputPortConv(params, 1).write(static_pointer_cast<StringValue>(params[0])->value());
+            return make_shared<NilValue>();
+        }
+    }
+
+    namespace Port
+    {
+        ValuePtr callWithInputFile(const ValueList& params, EvalEnv& env)
+        {
+            auto port = InputPort::open(stringConv(params[0]));
+            auto result = env.apply(params[1], ValueList{ make_shared<PortValue>(port) });
+            port->close();
+            return result;
+        }
+
+        ValuePtr closePort(const ValueList& params, EvalEnv& env)
+        {
+            auto& port = static_cast<const PortValue&>(*params[0]);
+            if (auto input = port.input())
+                input->close();
+            else
+                port.output()->close();
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr currentInputPort(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<PortValue>(currentInputPortPtr());
+        }
+
+        ValuePtr currentOutputPort(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<PortValue>(currentOutputPortPtr());
+        }
+
+        ValuePtr deleteFile(const ValueList& params, EvalEnv& env)
+        {
+            auto& fileName = stringConv(params[0]);
+            std::error_code error;
+            if (!std::filesystem::remove(fileName, error))
+                throw LispError("Delete file \"" + fileName + "\" failed" + (error ? ": " + error.message() : ""));
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr eofObject(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<EofValue>();
+        }
+
+        ValuePtr fileExists(const ValueList& params, EvalEnv& env)
+        {
+            std::error_code error;
+            return make_shared<BooleanValue>(std::filesystem::exists(stringConv(params[0]), error));
+        }
+
+        ValuePtr forEachLine(const ValueList& params, EvalEnv& env)
+        {
+            LineSource lines(stringConv(params[0]));
+            auto proc = static_pointer_cast<ProcValue>(params[1]);
+            shared_ptr<StringValue> line;
+            ValueList args(1);
+            while (auto text = lines.next())
+            {
+                reuseString(line, *text);
+                args[0] = line;
+                proc->call(args, env);
+                args[0] = nullptr;
+            }
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr forEachRecord(const ValueList& params, EvalEnv& env)
+        {
+            // Fields are split at every separator; there is no quoting.
+            LineSource lines(stringConv(params[0]));
+            char separator = charConv(params[1]);
+            auto proc = static_pointer_cast<ProcValue>(params[2]);
+            vector<shared_ptr<StringValue>> fields;
+            ValueList args(1);
+            while (auto text = lines.next())
+            {
+                ListBuilder record;
+                for (size_t i = 0, start = 0; start <= text->size(); i++)
+                {
+                    auto end = static_cast<const char*>(std::memchr(text->data() + start, separator, text->size() - start));
+                    size_t length = end ? end - (text->data() + start) : text->size() - start;
+                    if (i == fields.size())
+                        fields.emplace_back();
+                    reuseString(fields[i], text->substr(start, length));
+                    record.append(fields[i]);
+                    start += length + 1;
+                }
+                args[0] = record.release();
+                proc->call(args, env);
+                args[0] = nullptr;
+            }
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr getOutputString(const ValueList& params, EvalEnv& env)
+        {
+            auto port = static_pointer_cast<PortValue>(params[0])->output();
+            if (!port || !port->isString())
+                throw LispError(params[0]->toString() + " is not a string port");
+            return make_shared<StringValue>(port->text());
+        }
+
+        ValuePtr isInputPort(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<BooleanValue>(params[0]->isType(ValueType::PortType) && static_pointer_cast<PortValue>(params[0])->input());
+        }
+
+        ValuePtr isOutputPort(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<BooleanValue>(params[0]->isType(ValueType::PortType) && static_pointer_cast<PortValue>(params[0])->output());
+        }
+
+        ValuePtr openInputFile(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<PortValue>(InputPort::open(stringConv(params[0])));
+        }
+
+        ValuePtr openOutputFile(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<PortValue>(OutputPort::open(stringConv(params[0])));
+        }
+
+        ValuePtr openOutputString(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<PortValue>(make_shared<OutputPort>());
+        }
+
+        ValuePtr peekChar(const ValueList& params, EvalEnv& env)
+        {
+            return charOrEof(inputPortConv(params, 0).peekChar());
+        }
+
+        ValuePtr readChar(const ValueList& params, EvalEnv& env)
+        {
+            return charOrEof(inputPortConv(params, 0).readChar());
+        }
+
+        ValuePtr readLine(const ValueList& params, EvalEnv& env)
+        {
+            auto line = inputPortConv(params, 0).readLine();
+            if (!line)
+                return make_shared<EofValue>();
+            return make_shared<StringValue>(string(*line));
+        }
+
+        ValuePtr withOutputToString(const ValueList& params, EvalEnv& env)
+        {
+            auto port = make_shared<OutputPort>();
+            {
+                OutputRedirection redirection(port);
+                env.apply(params[0], ValueList{});
+            }
+            return make_shared<StringValue>(port->text());
+        }
     }
 
     namespace TypeCheck
@@ -237,21 +600,43 @@ namespace Builtin
             }
         }
 
+        ValuePtr sort(const ValueList& params, EvalEnv& env)
+        {
+            // A stable sort, so items less? does not order keep their order; less? must be a strict weak
+            // order, as for any standard sort. The arguments are values already, so less? is called
+            // directly instead of through apply, which would evaluate them.
+            bool isVector = params[0]->isType(ValueType::VectorType);
+            if (!isVector && !params[0]->isType(ValueType::ListType))
+                throw LispError(params[0]->toString() + " is not a list or vector");
+            auto items = isVector ? static_pointer_cast<VectorValue>(params[0])->value() : params[0]->toVector();
+            auto less = static_pointer_cast<ProcValue>(params[1]);
+            ValueList args(2);
+            std::stable_sort(items.begin(), items.end(), [&](const ValuePtr& lhs, const ValuePtr& rhs)
+            {
+                args[0] = lhs;
+                args[1] = rhs;
+                return static_cast<bool>(*less->call(args, env));
+            });
+            if (isVector)
+                return make_shared<VectorValue>(std::move(items));
+            return ListValue::fromVector(items);
+        }
+
     }
 
     namespace Math
     {
         ValuePtr add(const ValueList& params, EvalEnv& env)
         {
-            double result = 0;
+            Number result = 0;
             for (const auto& i : params)
             {
-                auto val = i->asNumber();
+                auto val = std::dynamic_pointer_cast<NumericValue>(i);
                 if (!val)
                 {
                     throw LispError("Cannot add a non-numeric value.");
                 }
-                result += *val;
+                result = result + val->value();
             }
             return std::make_shared<NumericValue>(result);
         }
@@ -262,57 +647,62 @@ namespace Builtin
             {
             case 1:
             {
-                return make_shared<NumericValue>(-*params[0]->asNumber());
+                return make_shared<NumericValue>(-numberConv(params[0]));
             }
             default:
-                return make_shared<NumericValue>(*params[0]->asNumber() - *params[1]->asNumber());
+                return make_shared<NumericValue>(numberConv(params[0]) - numberConv(params[1]));
             }
         }
 
         ValuePtr multiply(const ValueList& params, EvalEnv& env)
         {
-            double result = 1;
+            Number result = 1;
             for (auto& value : params)
             {
-                result *= *value->asNumber();
+                result = result * numberConv(value);
             }
             return make_shared<NumericValue>(result);
         }
 
         ValuePtr divide(const ValueList& params, EvalEnv& env)
         {
-            double x = 1, y = 0;
+            Number x = 1, y = 0;
             switch (params.size())
             {
             case 1:
             {
                 x = 1;
-                y = *params[0]->asNumber();
+                y = numberConv(params[0]);
                 break;
             }
             case 2:
             {
-                x = *params[0]->asNumber();
-                y = *params[1]->asNumber();
+                x = numberConv(params[0]);
+                y = numberConv(params[1]);
                 break;
             }
             default:
                 break;
             }
 
-            if (y == 0)
+            if (y.isZero())
                 throw LispError("Divided by 0");
-            return make_shared<NumericValue>(x / y);
+            return make_shared<NumericValue>(Number::divide(x, y));
         }
 
         ValuePtr abs(const ValueList& params, EvalEnv& env)
         {
-            return make_shared<NumericValue>(std::abs(*params[0]->asNumber()));
+            return make_shared<NumericValue>(Number::abs(numberConv(params[0])));
         }
 
         ValuePtr expt(const ValueList& params, EvalEnv& env)
         {
-            double x = *params[0]->asNumber(), y = *params[1]->asNumber();
+            Number base = numberConv(params[0]), exponent = numberConv(params[1]);
+            if (base.isExact() && exponent.isExact() && !exponent.isNegative())
+            {
+                return make_shared<NumericValue>(Number::expt(base, exponent));
+            }
+            double x = base.toDouble(), y = exponent.toDouble();
             if (x == 0 && y == 0)
             {
                 throw LispError("Not a number");
@@ -334,64 +724,62 @@ namespace Builtin
 
         ValuePtr quotient(const ValueList& params, EvalEnv& env)
         {
-            double x = *params[0]->asNumber(), y = *params[1]->asNumber();
-            if (y == 0)
+            Number x = numberConv(params[0]), y = numberConv(params[1]);
+            if (y.isZero())
                 throw LispError("Divided by 0");
-            double result = x / y;
-            return make_shared<NumericValue>(static_cast<long long>(result));
+            return make_shared<NumericValue>(Number::quotient(x, y));
         }
 
         ValuePtr remainder(const ValueList& params, EvalEnv& env)
         {
-            double x = *params[0]->asNumber(), y = *params[1]->asNumber();
-            if (y == 0)
+            Number x = numberConv(params[0]), y = numberConv(params[1]);
+            if (y.isZero())
                 throw LispError("Divided by 0");
-            return make_shared<NumericValue>(x - y * static_cast<long long>(x / y));
+            return make_shared<NumericValue>(Number::remainder(x, y));
         }
 
         ValuePtr modulo(const ValueList& params, EvalEnv& env)
         {
-            double x = *params[0]->asNumber(), y = *params[1]->asNumber();
-            double result = x;
-            if (y != 0)
-            {
-                result = x - static_cast<long long>(x / y) * y;
-                if (result * y < 0)
-                    result += y;
-                //if (result > 0 && y < 0)
-                    //result -= y;
-            }
-            return make_shared<NumericValue>(result);
+            Number x = numberConv(params[0]), y = numberConv(params[1]);
+            if (y.isZero())
+                return make_shared<NumericValue>(x);
+            return make_shared<NumericValue>(Number::modulo(x, y));
         }
 
         ValuePtr gcd(const ValueList& params, EvalEnv& e)
         {
-            if (!std::dynamic_pointer_cast<NumericValue>(params[0])->isInteger() && std::dynamic_pointer_cast<NumericValue>(params[1])->isInteger())
+            Number x = numberConv(params[0]), y = numberConv(params[1]);
+            if (!x.isInteger() || !y.isInteger())
             {
                 throw LispError("gcd only works on two integers");
             }
-            long long x = std::abs(*params[0]->asNumber()), y = std::abs(*params[1]->asNumber());
-            if (x == 0 || y == 0)
-                return make_shared<NumericValue>(0);
-            else
-            {
-                while (x != 0 && y != 0)
-                    if (x > y)
-                        x = x % y;
-                    else
-                        y = y % x;
-            }
-            return make_shared<NumericValue>(x + y);
+            return make_shared<NumericValue>(Number::gcd(x, y));
         }
 
         ValuePtr lcm(const ValueList& params, EvalEnv& e)
         {
-            if (!std::dynamic_pointer_cast<NumericValue>(params[0])->isInteger() && std::dynamic_pointer_cast<NumericValue>(params[1])->isInteger())
+            Number x = numberConv(params[0]), y = numberConv(params[1]);
+            if (!x.isInteger() || !y.isInteger())
             {
                 throw LispError("lcm only works on two integers");
             }
-            long long x = std::abs(*params[0]->asNumber()), y = std::abs(*params[1]->asNumber());
-            return make_shared<NumericValue>(x * y / (*gcd(params, e)->asNumber()));
+            return make_shared<NumericValue>(Number::lcm(x, y));
+        }
+
+        ValuePtr numberToString(const ValueList& params, EvalEnv& env)
+        {
+            const Number& n = static_pointer_cast<NumericValue>(params[0])->value();
+            int radix = 10;
+            if (params.size() >= 2)
+            {
+                auto r = std::dynamic_pointer_cast<NumericValue>(params[1]);
+                if (!r->isInteger() || (r->value() != 2 && r->value() != 8 && r->value() != 10 && r->value() != 16))
+                    throw LispError("Radix must be 2, 8, 10 or 16");
+                radix = static_cast<int>(*r->asNumber());
+            }
+            if (radix != 10 && !n.isExact())
+                throw LispError("Inexact numbers can only be written in radix 10");
+            return make_shared<StringValue>(n.toString(radix));
         }
 
     }
@@ -508,30 +896,92 @@ namespace Builtin
             return make_shared<NilValue>();
         }
 
-        BuiltinFunc stringEqual = std::bind(compare<string>(), _1, isEqual<string>(), stringConv);
-        BuiltinFunc stringEqualCi = std::bind(compare<string>(), _1, isEqual<string>(), stringCiConv);
-        BuiltinFunc stringGreater = std::bind(compare<string>(), _1, std::greater<string>(), stringConv);
-        BuiltinFunc stringSmaller = std::bind(compare<string>(), _1, std::less<string>(), stringConv);
-        BuiltinFunc stringGreaterOrEqual = std::bind(compare<string>(), _1, std::greater_equal<string>(), stringConv);
-        BuiltinFunc stringSmallerOrEqual = std::bind(compare<string>(), _1, std::less_equal<string>(), stringConv);
-        BuiltinFunc stringGreaterCi = std::bind(compare<string>(), _1, std::greater<string>(), stringCiConv);
-        BuiltinFunc stringSmallerCi = std::bind(compare<string>(), _1, std::less<string>(), stringCiConv);
-        BuiltinFunc stringGreaterOrEqualCi = std::bind(compare<string>(), _1, std::greater_equal<string>(), stringCiConv);
-        BuiltinFunc stringSmallerOrEqualCi = std::bind(compare<string>(), _1, std::less_equal<string>(), stringCiConv);
+        ValuePtr stringContains(const ValueList& params, EvalEnv& env)
+        {
+            auto text = stringViewConv(params[0]);
+            return indexOrFalse(search(text, stringViewConv(params[1]), startConv(params, 2, text.size())));
+        }
+
+        ValuePtr stringIndex(const ValueList& params, EvalEnv& env)
+        {
+            auto text = stringViewConv(params[0]);
+            return indexOrFalse(text.find(charConv(params[1]), startConv(params, 2, text.size())));
+        }
+
+        ValuePtr stringJoin(const ValueList& params, EvalEnv& env)
+        {
+            // The result is sized once, so joining n pieces copies each of them once.
+            auto pieces = params[0]->toVector();
+            std::string_view separator = params.size() > 1 ? stringViewConv(params[1]) : " "sv;
+            size_t size = pieces.empty() ? 0 : separator.size() * (pieces.size() - 1);
+            for (auto& piece : pieces)
+            {
+                if (!piece->isType(ValueType::StringType))
+                    throw LispError(piece->toString() + " is not string");
+                size += stringViewConv(piece).size();
+            }
+            string result;
+            result.reserve(size);
+            for (size_t i = 0; i < pieces.size(); i++)
+            {
+                if (i > 0)
+                    result += separator;
+                result += stringViewConv(pieces[i]);
+            }
+            return make_shared<StringValue>(std::move(result));
+        }
+
+        ValuePtr stringPrefix(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<BooleanValue>(stringViewConv(params[1]).starts_with(stringViewConv(params[0])));
+        }
+
+        ValuePtr stringSearch(const ValueList& params, EvalEnv& env)
+        {
+            auto text = stringViewConv(params[1]);
+            return indexOrFalse(search(text, stringViewConv(params[0]), startConv(params, 2, text.size())));
+        }
+
+        ValuePtr stringSplit(const ValueList& params, EvalEnv& env)
+        {
+            // The separator is a character or a non-empty string; every occurrence splits, so there can be
+            // empty fields.
+            auto text = stringViewConv(params[0]);
+            char separatorChar = 0;
+            std::string_view separator;
+            if (params[1]->isType(ValueType::CharType))
+            {
+                separatorChar = charConv(params[1]);
+                separator = std::string_view(&separatorChar, 1);
+            }
+            else if (params[1]->isType(ValueType::StringType))
+            {
+                separator = stringViewConv(params[1]);
+            }
+            if (separator.empty())
+                throw LispError(params[1]->toString() + " is not a character or a non-empty string");
+            ListBuilder fields;
+            size_t start = 0;
+            while (true)
+            {
+                size_t end = search(text, separator, start);
+                if (end == std::string_view::npos)
+                    break;
+                fields.append(make_shared<StringValue>(string(text.substr(start, end - start))));
+                start = end + separator.size();
+            }
+            fields.append(make_shared<StringValue>(string(text.substr(start))));
+            return fields.release();
+        }
+
+        ValuePtr stringSuffix(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<BooleanValue>(stringViewConv(params[1]).ends_with(stringViewConv(params[0])));
+        }
     }
 
     namespace Char
     {
-        BuiltinFunc charEqual = std::bind(compare<char>(), _1, isEqual<char>(), charConv);
-        BuiltinFunc charEqualCi = std::bind(compare<char>(), _1, isEqual<char>(), charCiConv);
-        BuiltinFunc charGreater = std::bind(compare<char>(), _1, std::greater<char>(), charConv);
-        BuiltinFunc charSmaller = std::bind(compare<char>(), _1, std::less<char>(), charConv);
-        BuiltinFunc charGreaterOrEqual = std::bind(compare<char>(), _1, std::greater_equal<char>(), charConv);
-        BuiltinFunc charSmallerOrEqual = std::bind(compare<char>(), _1, std::less_equal<char>(), charConv);
-        BuiltinFunc charGreaterCi = std::bind(compare<char>(), _1, std::greater<char>(), charCiConv);
-        BuiltinFunc charSmallerCi = std::bind(compare<char>(), _1, std::less<char>(), charCiConv);
-        BuiltinFunc charGreaterOrEqualCi = std::bind(compare<char>(), _1, std::greater_equal<char>(), charCiConv);
-        BuiltinFunc charSmallerOrEqualCi = std::bind(compare<char>(), _1, std::less_equal<char>(), charCiConv);
 
         ValuePtr isCharAlphabetic(const ValueList& params, EvalEnv& env)
         {
@@ -673,12 +1123,524 @@ namespace Builtin
         }
     }
 
+    namespace F64Vector
+    {
+        vector<double>& f64vectorConv(ValuePtr value)
+        {
+            return std::dynamic_pointer_cast<F64VectorValue>(value)->value();
+        }
+
+        vector<double> toDoubles(const ValueList& values)
+        {
+            vector<double> result;
+            result.reserve(values.size());
+            for (auto& value : values)
+            {
+                auto number = value->asNumber();
+                if (!number)
+                    throw LispError(value->toString() + " is not a number");
+                result.push_back(*number);
+            }
+            return result;
+        }
+
+        long long indexConv(ValuePtr value)
+        {
+            auto n = std::dynamic_pointer_cast<NumericValue>(value);
+            if (!n->isInteger())
+                throw LispError("Index should be an integer");
+            return *n->asNumber();
+        }
+
+        void assertSameSize(const vector<double>& lhs, const vector<double>& rhs)
+        {
+            if (lhs.size() != rhs.size())
+                throw LispError("f64vector length mismatch: " + to_string(lhs.size()) + " != " + to_string(rhs.size()));
+        }
+
+        void assertNotEmpty(const vector<double>& v)
+        {
+            if (v.empty())
+                throw LispError("f64vector must have at least 1 element");
+        }
+
+        ValuePtr makeF64Vector(const ValueList& params, EvalEnv& env)
+        {
+            auto n = std::dynamic_pointer_cast<NumericValue>(params[0]);
+            if (!n->isInteger())
+                throw LispError("k should be an integer");
+            long long k = *n->asNumber();
+            if (k < 0)
+                throw LispError("k should be non-negative");
+            double filler = params.size() >= 2 ? *params[1]->asNumber() : 0;
+            return make_shared<F64VectorValue>(k, filler);
+        }
+
+        ValuePtr _f64vector(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<F64VectorValue>(toDoubles(params));
+        }
+
+        ValuePtr f64vectorLength(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<NumericValue>(f64vectorConv(params[0]).size());
+        }
+
+        ValuePtr f64vectorRef(const ValueList& params, EvalEnv& env)
+        {
+            auto v = std::dynamic_pointer_cast<F64VectorValue>(params[0]);
+            return make_shared<NumericValue>(v->at(indexConv(params[1])));
+        }
+
+        ValuePtr f64vectorSet(const ValueList& params, EvalEnv& env)
+        {
+            auto v = std::dynamic_pointer_cast<F64VectorValue>(params[0]);
+            v->at(indexConv(params[1])) = *params[2]->asNumber();
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr f64vectorToList(const ValueList& params, EvalEnv& env)
+        {
+            auto& v = f64vectorConv(params[0]);
+            ValueList result;
+            result.reserve(v.size());
+            for (double d : v)
+                result.push_back(make_shared<NumericValue>(d));
+            return ListValue::fromVector(result);
+        }
+
+        ValuePtr listToF64vector(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<F64VectorValue>(toDoubles(params[0]->toVector()));
+        }
+
+        ValuePtr f64vectorToVector(const ValueList& params, EvalEnv& env)
+        {
+            auto& v = f64vectorConv(params[0]);
+            ValueList result;
+            result.reserve(v.size());
+            for (double d : v)
+                result.push_back(make_shared<NumericValue>(d));
+            return make_shared<VectorValue>(std::move(result));
+        }
+
+        ValuePtr vectorToF64vector(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<F64VectorValue>(toDoubles(std::dynamic_pointer_cast<VectorValue>(params[0])->value()));
+        }
+
+        ValuePtr f64vectorAdd(const ValueList& params, EvalEnv& env)
+        {
+            auto& lhs = f64vectorConv(params[0]);
+            auto& rhs = f64vectorConv(params[1]);
+            assertSameSize(lhs, rhs);
+            auto result = make_shared<F64VectorValue>(lhs.size());
+            Simd::add(lhs.data(), rhs.data(), result->value().data(), lhs.size());
+            return result;
+        }
+
+        ValuePtr f64vectorScale(const ValueList& params, EvalEnv& env)
+        {
+            auto& v = f64vectorConv(params[0]);
+            auto result = make_shared<F64VectorValue>(v.size());
+            Simd::scale(v.data(), *params[1]->asNumber(), result->value().data(), v.size());
+            return result;
+        }
+
+        ValuePtr f64vectorDot(const ValueList& params, EvalEnv& env)
+        {
+            auto& lhs = f64vectorConv(params[0]);
+            auto& rhs = f64vectorConv(params[1]);
+            assertSameSize(lhs, rhs);
+            return make_shared<NumericValue>(Simd::dot(lhs.data(), rhs.data(), lhs.size()));
+        }
+
+        ValuePtr f64vectorSum(const ValueList& params, EvalEnv& env)
+        {
+            auto& v = f64vectorConv(params[0]);
+            return make_shared<NumericValue>(Simd::sum(v.data(), v.size()));
+        }
+
+        ValuePtr f64vectorMin(const ValueList& params, EvalEnv& env)
+        {
+            auto& v = f64vectorConv(params[0]);
+            assertNotEmpty(v);
+            return make_shared<NumericValue>(Simd::min(v.data(), v.size()));
+        }
+
+        ValuePtr f64vectorMax(const ValueList& params, EvalEnv& env)
+        {
+            auto& v = f64vectorConv(params[0]);
+            assertNotEmpty(v);
+            return make_shared<NumericValue>(Simd::max(v.data(), v.size()));
+        }
+
+        ValuePtr f64vectorMap(const ValueList& params, EvalEnv& env)
+        {
+            static const unordered_map<string, Simd::UnaryOp> unaryOps =
+            {
+                {"abs"s, Simd::UnaryOp::Abs},
+                {"-"s, Simd::UnaryOp::Negate},
+                {"square"s, Simd::UnaryOp::Square},
+                {"sqrt"s, Simd::UnaryOp::Sqrt},
+                {"floor"s, Simd::UnaryOp::Floor},
+                {"ceiling"s, Simd::UnaryOp::Ceiling},
+                {"round"s, Simd::UnaryOp::Round},
+                {"exp"s, Simd::UnaryOp::Exp},
+                {"log"s, Simd::UnaryOp::Log},
+                {"sin"s, Simd::UnaryOp::Sin},
+                {"cos"s, Simd::UnaryOp::Cos},
+            };
+            auto& v = f64vectorConv(params[1]);
+            auto result = make_shared<F64VectorValue>(v.size());
+            auto& out = result->value();
+            // A builtin with a kernel, such as abs, runs over the whole vector at once. So does a quoted
+            // operation name, which also covers the kernels with no builtin: (f64vector-map 'sqrt v).
+            if (params[0]->isType(ValueType::BuiltinProcType))
+            {
+                auto iter = unaryOps.find(string(Builtin::nameOf(*params[0])));
+                if (iter != unaryOps.end())
+                {
+                    Simd::map(iter->second, v.data(), out.data(), v.size());
+                    return result;
+                }
+            }
+            else if (auto name = params[0]->asSymbol())
+            {
+                auto iter = unaryOps.find(*name);
+                if (iter == unaryOps.end())
+                    throw LispError("Unknown f64vector operation " + *name);
+                Simd::map(iter->second, v.data(), out.data(), v.size());
+                return result;
+            }
+            if (!params[0]->isType(ValueType::ProcedureType))
+                throw LispError(params[0]->toString() + " is not a procedure or operation name");
+            for (size_t i = 0; i < v.size(); i++)
+            {
+                auto mapped = env.apply(params[0], ValueList{ make_shared<NumericValue>(v[i]) })->asNumber();
+                if (!mapped)
+                    throw LispError("f64vector-map procedure must return a number");
+                out[i] = *mapped;
+            }
+            return result;
+        }
+    }
+
+    namespace Matrix
+    {
+        shared_ptr<MatrixValue> matrixConv(ValuePtr value)
+        {
+            return std::dynamic_pointer_cast<MatrixValue>(value);
+        }
+
+        size_t dimensionConv(ValuePtr value)
+        {
+            auto n = std::dynamic_pointer_cast<NumericValue>(value);
+            if (!n->isInteger() || *n->asNumber() < 0)
+                throw LispError("Matrix dimension should be a non-negative integer");
+            return *n->asNumber();
+        }
+
+        ValuePtr makeMatrix(const ValueList& params, EvalEnv& env)
+        {
+            size_t rows = dimensionConv(params[0]);
+            size_t cols = dimensionConv(params[1]);
+            double filler = params.size() >= 3 ? *params[2]->asNumber() : 0;
+            return make_shared<MatrixValue>(rows, cols, filler);
+        }
+
+        ValuePtr matrixRows(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<NumericValue>(matrixConv(params[0])->rows());
+        }
+
+        ValuePtr matrixCols(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<NumericValue>(matrixConv(params[0])->cols());
+        }
+
+        ValuePtr matrixRef(const ValueList& params, EvalEnv& env)
+        {
+            auto m = matrixConv(params[0]);
+            return make_shared<NumericValue>(m->at(F64Vector::indexConv(params[1]), F64Vector::indexConv(params[2])));
+        }
+
+        ValuePtr matrixSet(const ValueList& params, EvalEnv& env)
+        {
+            auto m = matrixConv(params[0]);
+            m->at(F64Vector::indexConv(params[1]), F64Vector::indexConv(params[2])) = *params[3]->asNumber();
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr matrixAdd(const ValueList& params, EvalEnv& env)
+        {
+            auto lhs = matrixConv(params[0]);
+            auto rhs = matrixConv(params[1]);
+            if (lhs->rows() != rhs->rows() || lhs->cols() != rhs->cols())
+                throw LispError("Matrix dimensions mismatch in matrix-add");
+            auto result = make_shared<MatrixValue>(lhs->rows(), lhs->cols());
+            Simd::add(lhs->value().data(), rhs->value().data(), result->value().data(), lhs->value().size());
+            return result;
+        }
+
+        ValuePtr matrixMul(const ValueList& params, EvalEnv& env)
+        {
+            auto lhs = matrixConv(params[0]);
+            auto rhs = matrixConv(params[1]);
+            if (lhs->cols() != rhs->rows())
+                throw LispError("Matrix dimensions mismatch in matrix-mul: " + to_string(lhs->cols()) + " != " + to_string(rhs->rows()));
+            auto result = make_shared<MatrixValue>(lhs->rows(), rhs->cols());
+            Simd::matmul(lhs->value().data(), rhs->value().data(), result->value().data(), lhs->rows(), lhs->cols(), rhs->cols());
+            return result;
+        }
+
+        ValuePtr matrixTranspose(const ValueList& params, EvalEnv& env)
+        {
+            auto m = matrixConv(params[0]);
+            auto result = make_shared<MatrixValue>(m->cols(), m->rows());
+            Simd::transpose(m->value().data(), result->value().data(), m->rows(), m->cols());
+            return result;
+        }
+
+        ValuePtr matrixRow(const ValueList& params, EvalEnv& env)
+        {
+            auto m = matrixConv(params[0]);
+            const double* row = m->row(F64Vector::indexConv(params[1]));
+            return make_shared<F64VectorValue>(vector<double>(row, row + m->cols()));
+        }
+
+        ValuePtr matrixColumn(const ValueList& params, EvalEnv& env)
+        {
+            auto m = matrixConv(params[0]);
+            long long col = F64Vector::indexConv(params[1]);
+            if (col < 0 || static_cast<size_t>(col) >= m->cols())
+                throw LispError("Column " + to_string(col) + " out of range");
+            vector<double> result(m->rows());
+            for (size_t i = 0; i < m->rows(); i++)
+                result[i] = m->value()[i * m->cols() + col];
+            return make_shared<F64VectorValue>(std::move(result));
+        }
+
+        ValuePtr listToMatrix(const ValueList& params, EvalEnv& env)
+        {
+            auto rows = params[0]->toVector();
+            vector<double> data;
+            size_t cols = 0;
+            for (size_t i = 0; i < rows.size(); i++)
+            {
+                auto row = F64Vector::toDoubles(rows[i]->toVector());
+                if (i == 0)
+                    cols = row.size();
+                else if (row.size() != cols)
+                    throw LispError("All rows of a matrix must have the same length");
+                data.insert(data.end(), row.begin(), row.end());
+            }
+            return make_shared<MatrixValue>(rows.size(), cols, std::move(data));
+        }
+
+        ValuePtr matrixToList(const ValueList& params, EvalEnv& env)
+        {
+            auto m = matrixConv(params[0]);
+            ValueList rows;
+            for (size_t i = 0; i < m->rows(); i++)
+            {
+                ValueList row;
+                for (size_t j = 0; j < m->cols(); j++)
+                    row.push_back(make_shared<NumericValue>(m->value()[i * m->cols() + j]));
+                rows.push_back(ListValue::fromVector(row));
+            }
+            return ListValue::fromVector(rows);
+        }
+    }
+
+    namespace Bytevector
+    {
+        shared_ptr<BytevectorValue> bytevectorConv(ValuePtr value)
+        {
+            return std::dynamic_pointer_cast<BytevectorValue>(value);
+        }
+
+        uint8_t byteConv(ValuePtr value)
+        {
+            auto n = std::dynamic_pointer_cast<NumericValue>(value);
+            if (!n || !n->isInteger() || *n->asNumber() < 0 || *n->asNumber() > 255)
+                throw LispError(value->toString() + " is not a byte");
+            return static_cast<uint8_t>(*n->asNumber());
+        }
+
+        // Whether the optional endianness argument at params[index] asks for big-endian; default is little.
+        bool isBigEndian(const ValueList& params, size_t index)
+        {
+            if (params.size() <= index)
+                return false;
+            auto name = params[index]->asSymbol();
+            if (name == "big")
+                return true;
+            if (name == "little")
+                return false;
+            throw LispError("Endianness should be 'big or 'little, got " + params[index]->toString());
+        }
+
+        template<typename T>
+        T loadTyped(const uint8_t* src, bool bigEndian)
+        {
+            uint8_t buffer[sizeof(T)];
+            std::memcpy(buffer, src, sizeof(T));
+            if (bigEndian != (std::endian::native == std::endian::big))
+                std::reverse(buffer, buffer + sizeof(T));
+            T result;
+            std::memcpy(&result, buffer, sizeof(T));
+            return result;
+        }
+
+        template<typename T>
+        void storeTyped(uint8_t* dst, T value, bool bigEndian)
+        {
+            std::memcpy(dst, &value, sizeof(T));
+            if (bigEndian != (std::endian::native == std::endian::big))
+                std::reverse(dst, dst + sizeof(T));
+        }
+
+        // Resolves optional [start [end]] arguments beginning at params[index] against a buffer of `size` bytes.
+        pair<size_t, size_t> rangeConv(const ValueList& params, size_t index, size_t size)
+        {
+            long long start = params.size() > index ? F64Vector::indexConv(params[index]) : 0;
+            long long end = params.size() > index + 1 ? F64Vector::indexConv(params[index + 1]) : size;
+            if (start < 0 || end < start || static_cast<size_t>(end) > size)
+                throw LispError("Invalid range [" + to_string(start) + ", " + to_string(end) + ")");
+            return { start, end };
+        }
+
+        ValuePtr makeBytevector(const ValueList& params, EvalEnv& env)
+        {
+            size_t k = Matrix::dimensionConv(params[0]);
+            uint8_t filler = params.size() >= 2 ? byteConv(params[1]) : 0;
+            return make_shared<BytevectorValue>(k, filler);
+        }
+
+        ValuePtr _bytevector(const ValueList& params, EvalEnv& env)
+        {
+            vector<uint8_t> bytes;
+            bytes.reserve(params.size());
+            for (auto& param : params)
+                bytes.push_back(byteConv(param));
+            return make_shared<BytevectorValue>(std::move(bytes));
+        }
+
+        ValuePtr bytevectorLength(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<NumericValue>(bytevectorConv(params[0])->size());
+        }
+
+        ValuePtr bytevectorU8Ref(const ValueList& params, EvalEnv& env)
+        {
+            return make_shared<NumericValue>(bytevectorConv(params[0])->at(F64Vector::indexConv(params[1])));
+        }
+
+        ValuePtr bytevectorU8Set(const ValueList& params, EvalEnv& env)
+        {
+            bytevectorConv(params[0])->at(F64Vector::indexConv(params[1])) = byteConv(params[2]);
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr bytevectorCopy(const ValueList& params, EvalEnv& env)
+        {
+            auto& bytes = bytevectorConv(params[0])->value();
+            auto [start, end] = rangeConv(params, 1, bytes.size());
+            return make_shared<BytevectorValue>(vector<uint8_t>(bytes.begin() + start, bytes.begin() + end));
+        }
+
+        ValuePtr bytevectorCopyInto(const ValueList& params, EvalEnv& env)
+        {
+            auto to = bytevectorConv(params[0]);
+            long long at = F64Vector::indexConv(params[1]);
+            auto& from = bytevectorConv(params[2])->value();
+            auto [start, end] = rangeConv(params, 3, from.size());
+            if (start == end)
+                return make_shared<NilValue>();
+            std::memmove(to->range(at, end - start), from.data() + start, end - start);
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr bytevectorFill(const ValueList& params, EvalEnv& env)
+        {
+            auto& bytes = bytevectorConv(params[0])->value();
+            std::memset(bytes.data(), byteConv(params[1]), bytes.size());
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr bytevectorU32Ref(const ValueList& params, EvalEnv& env)
+        {
+            auto src = bytevectorConv(params[0])->range(F64Vector::indexConv(params[1]), sizeof(uint32_t));
+            return make_shared<NumericValue>(loadTyped<uint32_t>(src, isBigEndian(params, 2)));
+        }
+
+        ValuePtr bytevectorU32Set(const ValueList& params, EvalEnv& env)
+        {
+            auto dst = bytevectorConv(params[0])->range(F64Vector::indexConv(params[1]), sizeof(uint32_t));
+            auto n = std::dynamic_pointer_cast<NumericValue>(params[2]);
+            if (!n->isInteger() || *n->asNumber() < 0 || *n->asNumber() > UINT32_MAX)
+                throw LispError(params[2]->toString() + " is not an unsigned 32-bit integer");
+            storeTyped<uint32_t>(dst, static_cast<uint32_t>(*n->asNumber()), isBigEndian(params, 3));
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr bytevectorF64Ref(const ValueList& params, EvalEnv& env)
+        {
+            auto src = bytevectorConv(params[0])->range(F64Vector::indexConv(params[1]), sizeof(double));
+            return make_shared<NumericValue>(loadTyped<double>(src, isBigEndian(params, 2)));
+        }
+
+        ValuePtr bytevectorF64Set(const ValueList& params, EvalEnv& env)
+        {
+            auto dst = bytevectorConv(params[0])->range(F64Vector::indexConv(params[1]), sizeof(double));
+            storeTyped<double>(dst, *params[2]->asNumber(), isBigEndian(params, 3));
+            return make_shared<NilValue>();
+        }
+
+        ValuePtr readBytevector(const ValueList& params, EvalEnv& env)
+        {
+            const string& fileName = stringConv(params[0]);
+            std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+                throw LispError("Open file \"" + fileName + "\" failed");
+            std::streamsize size = file.tellg();
+            file.seekg(0);
+            vector<uint8_t> bytes(size);
+            if (!file.read(reinterpret_cast<char*>(bytes.data()), size))
+                throw LispError("Read file \"" + fileName + "\" failed");
+            return make_shared<BytevectorValue>(std::move(bytes));
+        }
+
+        ValuePtr writeBytevector(const ValueList& params, EvalEnv& env)
+        {
+            auto& bytes = bytevectorConv(params[0])->value();
+            const string& fileName = stringConv(params[1]);
+            std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                throw LispError("Open file \"" + fileName + "\" failed");
+            if (!file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size()))
+                throw LispError("Write file \"" + fileName + "\" failed");
+            return make_shared<NilValue>();
+        }
+    }
+
     namespace Compare
     {
+        // Same exactness and numerically equal; avoids formatting both operands.
+        bool isEqvNumber(const ValuePtr& lhs, const ValuePtr& rhs)
+        {
+            const Number& x = static_pointer_cast<NumericValue>(lhs)->value();
+            const Number& y = static_pointer_cast<NumericValue>(rhs)->value();
+            return x.isExact() == y.isExact() && x == y;
+        }
+
         ValuePtr eq(const ValueList& params, EvalEnv& env)
         {
             if (params[0]->getTypeID() != params[1]->getTypeID())
                 return make_shared<BooleanValue>(false);
+            if (params[0]->isType(ValueType::NumericType))
+                return make_shared<BooleanValue>(isEqvNumber(params[0], params[1]));
             if (params[0]->isType(
                 ValueType::BooleanType |
                 ValueType::NumericType |
@@ -694,6 +1656,8 @@ namespace Builtin
 
         ValuePtr equal(const ValueList& params, EvalEnv& env)
         {
+            if (params[0]->isType(ValueType::NumericType) && params[1]->isType(ValueType::NumericType))
+                return make_shared<BooleanValue>(isEqvNumber(params[0], params[1]));
             return make_shared<BooleanValue>(params[0]->getTypeID() == params[1]->getTypeID() && params[0]->toString() == params[1]->toString());
         }
 
@@ -702,24 +1666,22 @@ namespace Builtin
             return make_shared<BooleanValue>(!*params[0]);
         }
 
-        BuiltinFunc less = std::bind(compare<double>(), _1, std::less<double>(), numberConv);
-        BuiltinFunc more = std::bind(compare<double>(), _1, std::greater<double>(), numberConv);
-        BuiltinFunc lessOrEqual = std::bind(compare<double>(), _1, std::less_equal<double>(), numberConv);
-        BuiltinFunc moreOrEqual = std::bind(compare<double>(), _1, std::greater_equal<double>(), numberConv);
 
         ValuePtr isEven(const ValueList& params, EvalEnv& env)
         {
-            return make_shared<BooleanValue>(static_pointer_cast<NumericValue>(params[0])->isInteger() && (std::abs(static_cast<long long>(*params[0]->asNumber())) % 2 == 0));
+            const Number& n = static_pointer_cast<NumericValue>(params[0])->value();
+            return make_shared<BooleanValue>(n.isInteger() && !n.isOdd());
         }
 
         ValuePtr isOdd(const ValueList& params, EvalEnv& env)
         {
-            return make_shared<BooleanValue>(static_pointer_cast<NumericValue>(params[0])->isInteger() && (std::abs(static_cast<long long>(*params[0]->asNumber())) % 2 == 1));
+            const Number& n = static_pointer_cast<NumericValue>(params[0])->value();
+            return make_shared<BooleanValue>(n.isInteger() && n.isOdd());
         }
 
         ValuePtr isZero(const ValueList& params, EvalEnv& env)
         {
-            return make_shared<BooleanValue>(*params[0]->asNumber() == 0);
+            return make_shared<BooleanValue>(numberConv(params[0]).isZero());
         }
 
     }
@@ -735,118 +1697,226 @@ namespace Builtin
 
 using namespace Builtin::Helper;
 
-unordered_map<string, CallablePtr> allBuiltins =
+namespace
 {
-    BuiltinItem("apply"s, Builtin::Core::apply, 2, 2, {ValueType::ProcedureType, ValueType::ListType}),
-    BuiltinItem("print"s, Builtin::Core::print),
-    BuiltinItem("display"s, Builtin::Core::display),
-    BuiltinItem("displayln"s, Builtin::Core::displayln),
-    BuiltinItem("error"s, Builtin::Core::error, 1),
-    BuiltinItem("eval"s, Builtin::Core::eval, 1, 1),
-    BuiltinItem("exit"s, Builtin::Core::exit, CallableValue::UnlimitedCnt, 1),
-    BuiltinItem("newline"s, Builtin::Core::newline),
-    BuiltinItem("read"s, Builtin::Core::read, 0, 0),
-
-    BuiltinItem("atom?"s, Builtin::TypeCheck::isType<ValueType::AtomType>, 1, 1),
-    BuiltinItem("boolean?"s, Builtin::TypeCheck::isType<ValueType::BooleanType>, 1,1),
-    BuiltinItem("number?"s, Builtin::TypeCheck::isType<ValueType::NumericType>, 1, 1),
-    BuiltinItem("null?"s, Builtin::TypeCheck::isType<ValueType::NilType>, 1, 1),
-    BuiltinItem("pair?"s, Builtin::TypeCheck::isType<ValueType::PairType>, 1, 1),
-    BuiltinItem("procedure?"s, Builtin::TypeCheck::isType<ValueType::ProcedureType>, 1, 1),
-    BuiltinItem("string?"s, Builtin::TypeCheck::isType<ValueType::StringType>, 1, 1),
-    BuiltinItem("symbol?"s, Builtin::TypeCheck::isType<ValueType::SymbolType>, 1, 1),
-    BuiltinItem("char?"s, Builtin::TypeCheck::isType<ValueType::CharType>, 1, 1),
-    BuiltinItem("vector?"s, Builtin::TypeCheck::isType<ValueType::VectorType>, 1, 1),
-    BuiltinItem("integer?"s, Builtin::TypeCheck::isInteger, 1, 1),
-    BuiltinItem("list?"s, Builtin::TypeCheck::isList, 1, 1),
-
-    BuiltinItem("append"s, Builtin::ListOperator::append),
-    BuiltinItem("car"s, Builtin::ListOperator::car, 1),
-    BuiltinItem("cdr"s, Builtin::ListOperator::cdr, 1),
-    BuiltinItem("cons"s, Builtin::ListOperator::cons, 2),
-    BuiltinItem("length"s, Builtin::ListOperator::length, 1),
-    BuiltinItem("list"s, Builtin::ListOperator::list),
-    BuiltinItem("map"s, Builtin::ListOperator::map, 2, CallableValue::UnlimitedCnt, {ValueType::ProcedureType, ValueType::ListType, CallableValue::SameToRest}),
-    BuiltinItem("filter"s, Builtin::ListOperator::filter, 2, 2, {ValueType::ProcedureType, ValueType::ListType}),
-    BuiltinItem("reduce"s, Builtin::ListOperator::reduce, 2, 2,{ValueType::ProcedureType, ValueType::ListType}),
-
-    BuiltinItem("+"s, Builtin::Math::add, CallableValue::UnlimitedCnt, CallableValue::UnlimitedCnt, {ValueType::NumericType, CallableValue::SameToRest}),
-    BuiltinItem("-"s, Builtin::Math::minus, 1, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("*"s, Builtin::Math::multiply, CallableValue::UnlimitedCnt, CallableValue::UnlimitedCnt, {ValueType::NumericType, CallableValue::SameToRest}),
-    BuiltinItem("/"s, Builtin::Math::divide, 1, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("abs"s, Builtin::Math::abs, 1, 1, {ValueType::NumericType}),
-    BuiltinItem("expt"s, Builtin::Math::expt, 2, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("quotient"s, Builtin::Math::quotient, 2, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("remainder"s, Builtin::Math::remainder, 2, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("modulo"s, Builtin::Math::modulo, 2, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("gcd"s,Builtin::Math::gcd,2,2,{ValueType::NumericType,ValueType::NumericType}),
-    BuiltinItem("lcm"s,Builtin::Math::lcm,2,2,{ValueType::NumericType,ValueType::NumericType}),
-
-    BuiltinItem("eq?"s, Builtin::Compare::eq, 2, 2),
-    BuiltinItem("equal?"s, Builtin::Compare::equal, 2, 2),
-    BuiltinItem("not"s, Builtin::Compare::_not, 1),
-    BuiltinItem("="s, Builtin::Compare::equal, 2, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("<"s, Builtin::Compare::less, 2, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem(">"s, Builtin::Compare::more, 2, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("<="s, Builtin::Compare::lessOrEqual, 2, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem(">="s, Builtin::Compare::moreOrEqual, 2, 2, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("even?"s, Builtin::Compare::isEven, 1, 1, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("odd?"s, Builtin::Compare::isOdd, 1, 1, {ValueType::NumericType, ValueType::NumericType}),
-    BuiltinItem("zero?"s, Builtin::Compare::isZero, 1, 1, {ValueType::NumericType, ValueType::NumericType}),
-
-    BuiltinItem("char=?"s,Builtin::Char::charEqual,2,2,{ValueType::CharType,ValueType::CharType}),
-    BuiltinItem("char-ci=?"s,Builtin::Char::charEqualCi,2,2,{ValueType::CharType,ValueType::CharType}),
-    BuiltinItem("char>?"s,Builtin::Char::charGreater,2,2,{ValueType::CharType,ValueType::CharType}),
-    BuiltinItem("char<?"s,Builtin::Char::charSmaller,2,2,{ValueType::CharType,ValueType::CharType}),
-    BuiltinItem("char>=?"s,Builtin::Char::charGreaterOrEqual,2,2,{ValueType::CharType,ValueType::CharType}),
-    BuiltinItem("char<=?"s,Builtin::Char::charSmallerOrEqual,2,2,{ValueType::CharType,ValueType::CharType}),
-    BuiltinItem("char-ci>?"s,Builtin::Char::charGreaterCi,2,2,{ValueType::CharType,ValueType::CharType}),
-    BuiltinItem("char-ci<?"s,Builtin::Char::charSmallerCi,2,2,{ValueType::CharType,ValueType::CharType}),
-    BuiltinItem("char-ci>=?"s,Builtin::Char::charGreaterOrEqualCi,2,2,{ValueType::CharType,ValueType::CharType}),
-    BuiltinItem("char-ci<=?"s,Builtin::Char::charSmallerOrEqualCi,2,2,{ValueType::CharType,ValueType::CharType}),
-    BuiltinItem("char-alphabetic?"s, Builtin::Char::isCharAlphabetic, 1, 1, {ValueType::CharType}),
-    BuiltinItem("char-numeric?"s, Builtin::Char::isCharNumeric, 1, 1, {ValueType::CharType}),
-    BuiltinItem("char-whitespace?"s, Builtin::Char::isCharWhitespace, 1, 1, {ValueType::CharType}),
-    BuiltinItem("char-uppercase?"s, Builtin::Char::isCharUpperCase, 1, 1, {ValueType::CharType}),
-    BuiltinItem("char-lowercase?"s, Builtin::Char::isCharLowerCase, 1, 1, {ValueType::CharType}),
-    BuiltinItem("char->integer"s, Builtin::Char::charToInteger, 1, 1, {ValueType::CharType}),
-    BuiltinItem("integer->char"s, Builtin::Char::integerToChar, 1, 1, {ValueType::NumericType}),
-    BuiltinItem("char-upcase"s, Builtin::Char::charUpcase, 1, 1,{ValueType::CharType}),
-    BuiltinItem("char-downcase"s, Builtin::Char::charDowncase, 1, 1,{ValueType::CharType}),
-
-
-
-    BuiltinItem("make-string"s, Builtin::String::makeString, 1,2,{ValueType::NumericType,ValueType::CharType}),
-    BuiltinItem("string"s,Builtin::String::_string,CallableValue::UnlimitedCnt,CallableValue::UnlimitedCnt,{ValueType::CharType,CallableValue::SameToRest}),
-    BuiltinItem("string-length"s,Builtin::String::stringLength,1,1,{ValueType::StringType}),
-    BuiltinItem("string-ref"s,Builtin::String::stringRef,2,2,{ValueType::StringType,ValueType::NumericType}),
-    BuiltinItem("string-set!"s,Builtin::String::stringSet,3,3,{ValueType::StringType,ValueType::NumericType,ValueType::CharType}),
-    BuiltinItem("string=?"s,Builtin::String::stringEqual,2,2,{ValueType::StringType,ValueType::StringType}),
-    BuiltinItem("string-ci=?"s,Builtin::String::stringEqualCi,2,2,{ValueType::StringType,ValueType::StringType}),
-    BuiltinItem("string>?"s,Builtin::String::stringGreater,2,2,{ValueType::StringType,ValueType::StringType}),
-    BuiltinItem("string<?"s,Builtin::String::stringSmaller,2,2,{ValueType::StringType,ValueType::StringType}),
-    BuiltinItem("string>=?"s,Builtin::String::stringGreaterOrEqual,2,2,{ValueType::StringType,ValueType::StringType}),
-    BuiltinItem("string<=?"s,Builtin::String::stringSmallerOrEqual,2,2,{ValueType::StringType,ValueType::StringType}),
-    BuiltinItem("string-ci>?"s,Builtin::String::stringGreaterCi,2,2,{ValueType::StringType,ValueType::StringType}),
-    BuiltinItem("string-ci<?"s,Builtin::String::stringSmallerCi,2,2,{ValueType::StringType,ValueType::StringType}),
-    BuiltinItem("string-ci>=?"s,Builtin::String::stringGreaterOrEqualCi,2,2,{ValueType::StringType,ValueType::StringType}),
-    BuiltinItem("string-ci<=?"s,Builtin::String::stringSmallerOrEqualCi,2,2,{ValueType::StringType,ValueType::StringType}),
-    BuiltinItem("substring"s,Builtin::String::subString,3,3,{ValueType::StringType,ValueType::NumericType,ValueType::NumericType}),
-    BuiltinItem("string-append"s,Builtin::String::stringAppend,2,CallableValue::UnlimitedCnt,{ValueType::StringType,CallableValue::SameToRest}),
-    BuiltinItem("string->list"s,Builtin::String::stringToList,1,1,{ValueType::StringType}),
-    BuiltinItem("list->string"s,Builtin::String::listToString,1,1,{ValueType::ListType}),
-    BuiltinItem("string-copy"s,Builtin::String::stringCopy,1,1,{ValueType::StringType}),
-    BuiltinItem("string-fill!"s,Builtin::String::stringFill,2,2,{ValueType::StringType,ValueType::CharType}),
-
-    BuiltinItem("make-vector"s, Builtin::Vector::makeVector, 1, 2, {ValueType::NumericType, ValueType::AllType}),
-    BuiltinItem("vector"s, Builtin::Vector::_vector),
-    BuiltinItem("vector-length"s, Builtin::Vector::vectorLength, 1, 1, { ValueType::VectorType }),
-    BuiltinItem("vector-ref"s, Builtin::Vector::vectorRef, 2, 2, { ValueType::VectorType,ValueType::NumericType }),
-    BuiltinItem("vector-set!"s, Builtin::Vector::vectorSet, 3, 3, { ValueType::VectorType,ValueType::NumericType,ValueType::AllType }),
-    BuiltinItem("vector->list"s, Builtin::Vector::vectorToList, 1, 1, { ValueType::VectorType }),
-    BuiltinItem("list->vector"s, Builtin::Vector::listToVector, 1, 1, { ValueType::ListType }),
-    BuiltinItem("vector-fill!"s, Builtin::Vector::vectorFill, 2, 2, { ValueType::VectorType,ValueType::AllType }),
-
-    BuiltinItem("force"s, Builtin::Control::force,1,1,{ValueType::PromiseType}),
-};
+    constexpr ProcSpec builtinSpecs[] =
+    {
+        { "apply", Builtin::Core::apply, 2, 2, paramTypes<ValueType::ProcedureType, ValueType::ListType> },
+        { "compile-file", Builtin::Core::compileFile, 1, 1, paramTypes<ValueType::StringType> },
+        { "print", Builtin::Core::print },
+        { "display", Builtin::Core::display },
+        { "displayln", Builtin::Core::displayln },
+        { "error", Builtin::Core::error, 1 },
+        { "error-object-message", Builtin::Core::errorObjectMessage, 1, 1, paramTypes<ValueType::ErrorType> },
+        { "eval", Builtin::Core::eval, 1, 1 },
+        { "exit", Builtin::Core::exit, CallableValue::UnlimitedCnt, 1 },
+        { "flush-output", Builtin::Core::flushOutput, 0, 0 },
+        { "load", Builtin::Core::load, 1, 1, paramTypes<ValueType::StringType> },
+        { "load-image", Builtin::Core::loadImage, 1, 1, paramTypes<ValueType::StringType> },
+        { "newline", Builtin::Core::newline, 0, 1, paramTypes<ValueType::PortType> },
+        { "print-depth", Builtin::Core::printDepth, 0, 1 },
+        { "print-length", Builtin::Core::printLength, 0, 1 },
+        { "read", Builtin::Core::read, 0, 1, paramTypes<ValueType::PortType> },
+        { "read-error?", Builtin::Core::isReadError, 1, 1 },
+        { "save-image", Builtin::Core::saveImage, 1, 1, paramTypes<ValueType::StringType> },
+        { "write", Builtin::Core::write, 1, 2, paramTypes<ValueType::AllType, ValueType::PortType> },
+        { "write-shared", Builtin::Core::writeShared, 1, 2, paramTypes<ValueType::AllType, ValueType::PortType> },
+        { "write-string", Builtin::Core::writeString, 1, 2, paramTypes<ValueType::StringType, ValueType::PortType> },
+
+        { "call-with-input-file", Builtin::Port::callWithInputFile, 2, 2, paramTypes<ValueType::StringType, ValueType::ProcedureType> },
+        { "close-port", Builtin::Port::closePort, 1, 1, paramTypes<ValueType::PortType> },
+        { "current-input-port", Builtin::Port::currentInputPort, 0, 0 },
+        { "current-output-port", Builtin::Port::currentOutputPort, 0, 0 },
+        { "delete-file", Builtin::Port::deleteFile, 1, 1, paramTypes<ValueType::StringType> },
+        { "eof-object", Builtin::Port::eofObject, 0, 0 },
+        { "file-exists?", Builtin::Port::fileExists, 1, 1, paramTypes<ValueType::StringType> },
+        { "for-each-line", Builtin::Port::forEachLine, 2, 2, paramTypes<ValueType::StringType, ValueType::ProcedureType> },
+        { "for-each-record", Builtin::Port::forEachRecord, 3, 3, paramTypes<ValueType::StringType, ValueType::CharType, ValueType::ProcedureType> },
+        { "get-output-string", Builtin::Port::getOutputString, 1, 1, paramTypes<ValueType::PortType> },
+        { "input-port?", Builtin::Port::isInputPort, 1, 1 },
+        { "open-input-file", Builtin::Port::openInputFile, 1, 1, paramTypes<ValueType::StringType> },
+        { "open-output-file", Builtin::Port::openOutputFile, 1, 1, paramTypes<ValueType::StringType> },
+        { "open-output-string", Builtin::Port::openOutputString, 0, 0 },
+        { "output-port?", Builtin::Port::isOutputPort, 1, 1 },
+        { "peek-char", Builtin::Port::peekChar, 0, 1, paramTypes<ValueType::PortType> },
+        { "read-char", Builtin::Port::readChar, 0, 1, paramTypes<ValueType::PortType> },
+        { "read-line", Builtin::Port::readLine, 0, 1, paramTypes<ValueType::PortType> },
+        { "with-output-to-string", Builtin::Port::withOutputToString, 1, 1, paramTypes<ValueType::ProcedureType> },
+
+        { "atom?", Builtin::TypeCheck::isType<ValueType::AtomType>, 1, 1 },
+        { "boolean?", Builtin::TypeCheck::isType<ValueType::BooleanType>, 1, 1 },
+        { "number?", Builtin::TypeCheck::isType<ValueType::NumericType>, 1, 1 },
+        { "null?", Builtin::TypeCheck::isType<ValueType::NilType>, 1, 1 },
+        { "pair?", Builtin::TypeCheck::isType<ValueType::PairType>, 1, 1 },
+        { "procedure?", Builtin::TypeCheck::isType<ValueType::ProcedureType>, 1, 1 },
+        { "string?", Builtin::TypeCheck::isType<ValueType::StringType>, 1, 1 },
+        { "symbol?", Builtin::TypeCheck::isType<ValueType::SymbolType>, 1, 1 },
+        { "char?", Builtin::TypeCheck::isType<ValueType::CharType>, 1, 1 },
+        { "vector?", Builtin::TypeCheck::isType<ValueType::VectorType>, 1, 1 },
+        { "port?", Builtin::TypeCheck::isType<ValueType::PortType>, 1, 1 },
+        { "eof-object?", Builtin::TypeCheck::isType<ValueType::EofType>, 1, 1 },
+        { "error-object?", Builtin::TypeCheck::isType<ValueType::ErrorType>, 1, 1 },
+        { "integer?", Builtin::TypeCheck::isInteger, 1, 1 },
+        { "list?", Builtin::TypeCheck::isList, 1, 1 },
+
+        { "append", Builtin::ListOperator::append },
+        { "car", Builtin::ListOperator::car, 1 },
+        { "cdr", Builtin::ListOperator::cdr, 1 },
+        { "cons", Builtin::ListOperator::cons, 2 },
+        { "length", Builtin::ListOperator::length, 1 },
+        { "list", Builtin::ListOperator::list },
+        { "map", Builtin::ListOperator::map, 2, CallableValue::UnlimitedCnt, paramTypes<ValueType::ProcedureType, ValueType::ListType, CallableValue::SameToRest> },
+        { "filter", Builtin::ListOperator::filter, 2, 2, paramTypes<ValueType::ProcedureType, ValueType::ListType> },
+        { "reduce", Builtin::ListOperator::reduce, 2, 2, paramTypes<ValueType::ProcedureType, ValueType::ListType> },
+        { "sort", Builtin::ListOperator::sort, 2, 2, paramTypes<ValueType::AllType, ValueType::ProcedureType> },
+
+        { "+", Builtin::Math::add, CallableValue::UnlimitedCnt, CallableValue::UnlimitedCnt, paramTypes<ValueType::NumericType, CallableValue::SameToRest> },
+        { "-", Builtin::Math::minus, 1, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "*", Builtin::Math::multiply, CallableValue::UnlimitedCnt, CallableValue::UnlimitedCnt, paramTypes<ValueType::NumericType, CallableValue::SameToRest> },
+        { "/", Builtin::Math::divide, 1, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "abs", Builtin::Math::abs, 1, 1, paramTypes<ValueType::NumericType> },
+        { "expt", Builtin::Math::expt, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "quotient", Builtin::Math::quotient, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "remainder", Builtin::Math::remainder, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "modulo", Builtin::Math::modulo, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "gcd", Builtin::Math::gcd, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "lcm", Builtin::Math::lcm, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "number->string", Builtin::Math::numberToString, 1, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+
+        { "eq?", Builtin::Compare::eq, 2, 2 },
+        { "equal?", Builtin::Compare::equal, 2, 2 },
+        { "not", Builtin::Compare::_not, 1 },
+        { "=", Builtin::Compare::numEqual, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "<", Builtin::Compare::less, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { ">", Builtin::Compare::more, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "<=", Builtin::Compare::lessOrEqual, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { ">=", Builtin::Compare::moreOrEqual, 2, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "even?", Builtin::Compare::isEven, 1, 1, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "odd?", Builtin::Compare::isOdd, 1, 1, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "zero?", Builtin::Compare::isZero, 1, 1, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+
+        { "char=?", Builtin::Char::charEqual, 2, 2, paramTypes<ValueType::CharType, ValueType::CharType> },
+        { "char-ci=?", Builtin::Char::charEqualCi, 2, 2, paramTypes<ValueType::CharType, ValueType::CharType> },
+        { "char>?", Builtin::Char::charGreater, 2, 2, paramTypes<ValueType::CharType, ValueType::CharType> },
+        { "char<?", Builtin::Char::charSmaller, 2, 2, paramTypes<ValueType::CharType, ValueType::CharType> },
+        { "char>=?", Builtin::Char::charGreaterOrEqual, 2, 2, paramTypes<ValueType::CharType, ValueType::CharType> },
+        { "char<=?", Builtin::Char::charSmallerOrEqual, 2, 2, paramTypes<ValueType::CharType, ValueType::CharType> },
+        { "char-ci>?", Builtin::Char::charGreaterCi, 2, 2, paramTypes<ValueType::CharType, ValueType::CharType> },
+        { "char-ci<?", Builtin::Char::charSmallerCi, 2, 2, paramTypes<ValueType::CharType, ValueType::CharType> },
+        { "char-ci>=?", Builtin::Char::charGreaterOrEqualCi, 2, 2, paramTypes<ValueType::CharType, ValueType::CharType> },
+        { "char-ci<=?", Builtin::Char::charSmallerOrEqualCi, 2, 2, paramTypes<ValueType::CharType, ValueType::CharType> },
+        { "char-alphabetic?", Builtin::Char::isCharAlphabetic, 1, 1, paramTypes<ValueType::CharType> },
+        { "char-numeric?", Builtin::Char::isCharNumeric, 1, 1, paramTypes<ValueType::CharType> },
+        { "char-whitespace?", Builtin::Char::isCharWhitespace, 1, 1, paramTypes<ValueType::CharType> },
+        { "char-uppercase?", Builtin::Char::isCharUpperCase, 1, 1, paramTypes<ValueType::CharType> },
+        { "char-lowercase?", Builtin::Char::isCharLowerCase, 1, 1, paramTypes<ValueType::CharType> },
+        { "char->integer", Builtin::Char::charToInteger, 1, 1, paramTypes<ValueType::CharType> },
+        { "integer->char", Builtin::Char::integerToChar, 1, 1, paramTypes<ValueType::NumericType> },
+        { "char-upcase", Builtin::Char::charUpcase, 1, 1, paramTypes<ValueType::CharType> },
+        { "char-downcase", Builtin::Char::charDowncase, 1, 1, paramTypes<ValueType::CharType> },
+
+
+
+        { "make-string", Builtin::String::makeString, 1, 2, paramTypes<ValueType::NumericType, ValueType::CharType> },
+        { "string", Builtin::String::_string, CallableValue::UnlimitedCnt, CallableValue::UnlimitedCnt, paramTypes<ValueType::CharType, CallableValue::SameToRest> },
+        { "string-length", Builtin::String::stringLength, 1, 1, paramTypes<ValueType::StringType> },
+        { "string-ref", Builtin::String::stringRef, 2, 2, paramTypes<ValueType::StringType, ValueType::NumericType> },
+        { "string-set!", Builtin::String::stringSet, 3, 3, paramTypes<ValueType::StringType, ValueType::NumericType, ValueType::CharType> },
+        { "string=?", Builtin::String::stringEqual, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "string-ci=?", Builtin::String::stringEqualCi, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "string>?", Builtin::String::stringGreater, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "string<?", Builtin::String::stringSmaller, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "string>=?", Builtin::String::stringGreaterOrEqual, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "string<=?", Builtin::String::stringSmallerOrEqual, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "string-ci>?", Builtin::String::stringGreaterCi, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "string-ci<?", Builtin::String::stringSmallerCi, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "string-ci>=?", Builtin::String::stringGreaterOrEqualCi, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "string-ci<=?", Builtin::String::stringSmallerOrEqualCi, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "substring", Builtin::String::subString, 3, 3, paramTypes<ValueType::StringType, ValueType::NumericType, ValueType::NumericType> },
+        { "string-append", Builtin::String::stringAppend, 2, CallableValue::UnlimitedCnt, paramTypes<ValueType::StringType, CallableValue::SameToRest> },
+        { "string->list", Builtin::String::stringToList, 1, 1, paramTypes<ValueType::StringType> },
+        { "list->string", Builtin::String::listToString, 1, 1, paramTypes<ValueType::ListType> },
+        { "string-copy", Builtin::String::stringCopy, 1, 1, paramTypes<ValueType::StringType> },
+        { "string-fill!", Builtin::String::stringFill, 2, 2, paramTypes<ValueType::StringType, ValueType::CharType> },
+        { "string-contains", Builtin::String::stringContains, 2, 3, paramTypes<ValueType::StringType, ValueType::StringType, ValueType::NumericType> },
+        { "string-index", Builtin::String::stringIndex, 2, 3, paramTypes<ValueType::StringType, ValueType::CharType, ValueType::NumericType> },
+        { "string-join", Builtin::String::stringJoin, 1, 2, paramTypes<ValueType::ListType, ValueType::StringType> },
+        { "string-prefix?", Builtin::String::stringPrefix, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+        { "string-search", Builtin::String::stringSearch, 2, 3, paramTypes<ValueType::StringType, ValueType::StringType, ValueType::NumericType> },
+        { "string-split", Builtin::String::stringSplit, 2, 2, paramTypes<ValueType::StringType> },
+        { "string-suffix?", Builtin::String::stringSuffix, 2, 2, paramTypes<ValueType::StringType, ValueType::StringType> },
+
+        { "make-vector", Builtin::Vector::makeVector, 1, 2, paramTypes<ValueType::NumericType, ValueType::AllType> },
+        { "vector", Builtin::Vector::_vector },
+        { "vector-length", Builtin::Vector::vectorLength, 1, 1, paramTypes<ValueType::VectorType> },
+        { "vector-ref", Builtin::Vector::vectorRef, 2, 2, paramTypes<ValueType::VectorType, ValueType::NumericType> },
+        { "vector-set!", Builtin::Vector::vectorSet, 3, 3, paramTypes<ValueType::VectorType, ValueType::NumericType, ValueType::AllType> },
+        { "vector->list", Builtin::Vector::vectorToList, 1, 1, paramTypes<ValueType::VectorType> },
+        { "list->vector", Builtin::Vector::listToVector, 1, 1, paramTypes<ValueType::ListType> },
+        { "vector-fill!", Builtin::Vector::vectorFill, 2, 2, paramTypes<ValueType::VectorType, ValueType::AllType> },
+
+        { "f64vector?", Builtin::TypeCheck::isType<ValueType::F64VectorType>, 1, 1 },
+        { "make-f64vector", Builtin::F64Vector::makeF64Vector, 1, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "f64vector", Builtin::F64Vector::_f64vector, CallableValue::UnlimitedCnt, CallableValue::UnlimitedCnt, paramTypes<ValueType::NumericType, CallableValue::SameToRest> },
+        { "f64vector-length", Builtin::F64Vector::f64vectorLength, 1, 1, paramTypes<ValueType::F64VectorType> },
+        { "f64vector-ref", Builtin::F64Vector::f64vectorRef, 2, 2, paramTypes<ValueType::F64VectorType, ValueType::NumericType> },
+        { "f64vector-set!", Builtin::F64Vector::f64vectorSet, 3, 3, paramTypes<ValueType::F64VectorType, ValueType::NumericType, ValueType::NumericType> },
+        { "f64vector->list", Builtin::F64Vector::f64vectorToList, 1, 1, paramTypes<ValueType::F64VectorType> },
+        { "list->f64vector", Builtin::F64Vector::listToF64vector, 1, 1, paramTypes<ValueType::ListType> },
+        { "f64vector->vector", Builtin::F64Vector::f64vectorToVector, 1, 1, paramTypes<ValueType::F64VectorType> },
+        { "vector->f64vector", Builtin::F64Vector::vectorToF64vector, 1, 1, paramTypes<ValueType::VectorType> },
+        { "f64vector-add", Builtin::F64Vector::f64vectorAdd, 2, 2, paramTypes<ValueType::F64VectorType, ValueType::F64VectorType> },
+        { "f64vector-scale", Builtin::F64Vector::f64vectorScale, 2, 2, paramTypes<ValueType::F64VectorType, ValueType::NumericType> },
+        { "f64vector-dot", Builtin::F64Vector::f64vectorDot, 2, 2, paramTypes<ValueType::F64VectorType, ValueType::F64VectorType> },
+        { "f64vector-sum", Builtin::F64Vector::f64vectorSum, 1, 1, paramTypes<ValueType::F64VectorType> },
+        { "f64vector-min", Builtin::F64Vector::f64vectorMin, 1, 1, paramTypes<ValueType::F64VectorType> },
+        { "f64vector-max", Builtin::F64Vector::f64vectorMax, 1, 1, paramTypes<ValueType::F64VectorType> },
+        { "f64vector-map", Builtin::F64Vector::f64vectorMap, 2, 2, paramTypes<ValueType::SymbolType | ValueType::ProcedureType, ValueType::F64VectorType> },
+
+        { "matrix?", Builtin::TypeCheck::isType<ValueType::MatrixType>, 1, 1 },
+        { "make-matrix", Builtin::Matrix::makeMatrix, 2, 3, paramTypes<ValueType::NumericType, ValueType::NumericType, ValueType::NumericType> },
+        { "matrix-rows", Builtin::Matrix::matrixRows, 1, 1, paramTypes<ValueType::MatrixType> },
+        { "matrix-cols", Builtin::Matrix::matrixCols, 1, 1, paramTypes<ValueType::MatrixType> },
+        { "matrix-ref", Builtin::Matrix::matrixRef, 3, 3, paramTypes<ValueType::MatrixType, ValueType::NumericType, ValueType::NumericType> },
+        { "matrix-set!", Builtin::Matrix::matrixSet, 4, 4, paramTypes<ValueType::MatrixType, ValueType::NumericType, ValueType::NumericType, ValueType::NumericType> },
+        { "matrix-add", Builtin::Matrix::matrixAdd, 2, 2, paramTypes<ValueType::MatrixType, ValueType::MatrixType> },
+        { "matrix-mul", Builtin::Matrix::matrixMul, 2, 2, paramTypes<ValueType::MatrixType, ValueType::MatrixType> },
+        { "matrix-transpose", Builtin::Matrix::matrixTranspose, 1, 1, paramTypes<ValueType::MatrixType> },
+        { "matrix-row", Builtin::Matrix::matrixRow, 2, 2, paramTypes<ValueType::MatrixType, ValueType::NumericType> },
+        { "matrix-column", Builtin::Matrix::matrixColumn, 2, 2, paramTypes<ValueType::MatrixType, ValueType::NumericType> },
+        { "list->matrix", Builtin::Matrix::listToMatrix, 1, 1, paramTypes<ValueType::ListType> },
+        { "matrix->list", Builtin::Matrix::matrixToList, 1, 1, paramTypes<ValueType::MatrixType> },
+
+        { "bytevector?", Builtin::TypeCheck::isType<ValueType::BytevectorType>, 1, 1 },
+        { "make-bytevector", Builtin::Bytevector::makeBytevector, 1, 2, paramTypes<ValueType::NumericType, ValueType::NumericType> },
+        { "bytevector", Builtin::Bytevector::_bytevector, CallableValue::UnlimitedCnt, CallableValue::UnlimitedCnt, paramTypes<ValueType::NumericType, CallableValue::SameToRest> },
+        { "bytevector-length", Builtin::Bytevector::bytevectorLength, 1, 1, paramTypes<ValueType::BytevectorType> },
+        { "bytevector-u8-ref", Builtin::Bytevector::bytevectorU8Ref, 2, 2, paramTypes<ValueType::BytevectorType, ValueType::NumericType> },
+        { "bytevector-u8-set!", Builtin::Bytevector::bytevectorU8Set, 3, 3, paramTypes<ValueType::BytevectorType, ValueType::NumericType, ValueType::NumericType> },
+        { "bytevector-copy", Builtin::Bytevector::bytevectorCopy, 1, 3, paramTypes<ValueType::BytevectorType, ValueType::NumericType, ValueType::NumericType> },
+        { "bytevector-copy!", Builtin::Bytevector::bytevectorCopyInto, 3, 5, paramTypes<ValueType::BytevectorType, ValueType::NumericType, ValueType::BytevectorType, ValueType::NumericType, ValueType::NumericType> },
+        { "bytevector-fill!", Builtin::Bytevector::bytevectorFill, 2, 2, paramTypes<ValueType::BytevectorType, ValueType::NumericType> },
+        { "bytevector-u32-ref", Builtin::Bytevector::bytevectorU32Ref, 2, 3, paramTypes<ValueType::BytevectorType, ValueType::NumericType, ValueType::SymbolType> },
+        { "bytevector-u32-set!", Builtin::Bytevector::bytevectorU32Set, 3, 4, paramTypes<ValueType::BytevectorType, ValueType::NumericType, ValueType::NumericType, ValueType::SymbolType> },
+        { "bytevector-f64-ref", Builtin::Bytevector::bytevectorF64Ref, 2, 3, paramTypes<ValueType::BytevectorType, ValueType::NumericType, ValueType::SymbolType> },
+        { "bytevector-f64-set!", Builtin::Bytevector::bytevectorF64Set, 3, 4, paramTypes<ValueType::BytevectorType, ValueType::NumericType, ValueType::NumericType, ValueType::SymbolType> },
+        { "read-bytevector", Builtin::Bytevector::readBytevector, 1, 1, paramTypes<ValueType::StringType> },
+        { "write-bytevector", Builtin::Bytevector::writeBytevector, 2, 2, paramTypes<ValueType::BytevectorType, ValueType::StringType> },
+
+        { "force", Builtin::Control::force, 1, 1, paramTypes<ValueType::PromiseType> },
+    };
+
+    constinit Registry<BuiltinProcValue, std::size(builtinSpecs)> builtinRegistry{ builtinSpecs };
+}
+
+CallablePtr Builtin::find(std::string_view name)
+{
+    return builtinRegistry.find(name);
+}
+
+std::string_view Builtin::nameOf(const Value& value)
+{
+    return builtinRegistry.nameOf(value);
+}
+
 
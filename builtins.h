@@ -11,8 +11,11 @@
 #include <functional>
 #include <ranges>
 #include <algorithm>
+#include <compare>
+#include <string_view>
 
 #include "./value.h"
+#include "./port.h"
 #include "./reader.h"
 
 using std::cout, std::vector, std::to_string, std::make_shared, std::unordered_map, std::pair, std::make_pair, std::static_pointer_cast, std::function;
@@ -21,28 +24,14 @@ class EvalEnv;
 
 namespace Builtin
 {
-    using namespace std::placeholders;
-
-    using BuiltinFunc = function<ValuePtr(const ValueList&, EvalEnv& env)>;
-
     namespace Helper // Not in builtin functions list
     {
-        pair<string, shared_ptr<BuiltinProcValue>> BuiltinItem(
-            string name,
-            FuncType func,
-            int minArgs = CallableValue::UnlimitedCnt,
-            int maxArgs = CallableValue::UnlimitedCnt,
-            const vector<int>& paramType = CallableValue::UnlimitedType
-        );
-
-        template<typename T>
-        struct compare
+        // A comparison builtin: converts both arguments with Conv and compares the results with Comp.
+        template<typename T, typename Comp, T(*Conv)(const ValuePtr&)>
+        ValuePtr compare(const ValueList& params, EvalEnv& env)
         {
-            ValuePtr operator()(const ValueList& params, const function<bool(const T&, const T&)>& Comp, const function<T(ValuePtr)>& Conv)
-            {
-                return make_shared<BooleanValue>(Comp(Conv(params[0]), Conv(params[1])));
-            }
-        };
+            return make_shared<BooleanValue>(Comp{}(Conv(params[0]), Conv(params[1])));
+        }
 
         template<typename T>
         struct isEqual
@@ -53,27 +42,79 @@ namespace Builtin
             }
         };
 
-        double numberConv(ValuePtr value);
-        string stringConv(ValuePtr value);
-        string stringCiConv(ValuePtr value);
-        char charConv(ValuePtr value);
-        char charCiConv(ValuePtr value);
+        // A string that compares ignoring ASCII case. It folds as it compares, instead of comparing lower
+        // case copies.
+        struct CiString
+        {
+            std::string_view text;
+            bool operator==(const CiString& other) const;
+            std::strong_ordering operator<=>(const CiString& other) const;
+        };
 
-        string ci(const string& s);
+        Number numberConv(const ValuePtr& value);
+        const string& stringConv(const ValuePtr& value);
+        // The text of a string value, without copying it; good while the value lives and is not changed.
+        std::string_view stringViewConv(const ValuePtr& value);
+        // The optional start index argument at index, checked against size; 0 if there is none.
+        size_t startConv(const ValueList& params, size_t index, size_t size);
+        CiString stringCiConv(const ValuePtr& value);
+        char charConv(const ValuePtr& value);
+        char charCiConv(const ValuePtr& value);
+        // (print-length) and (print-depth): returns limit, or sets it from a count or #f (no limit).
+        ValuePtr printLimit(const ValueList& params, size_t& limit);
+        // The port argument at index, or the current port if there are fewer arguments. Throws if the
+        // port is the other kind, or closed.
+        OutputPort& outputPortConv(const ValueList& params, size_t index);
+        InputPort& inputPortConv(const ValueList& params, size_t index);
     }
     using namespace Builtin::Helper;
 
     namespace Core
     {
         ValuePtr apply(const ValueList& params, EvalEnv& env);
+        ValuePtr compileFile(const ValueList& params, EvalEnv& env);
         ValuePtr print(const ValueList& params, EvalEnv& env);
         ValuePtr display(const ValueList& params, EvalEnv& env);
         ValuePtr displayln(const ValueList& params, EvalEnv& env);
         ValuePtr error(const ValueList& params, EvalEnv& env);
+        ValuePtr errorObjectMessage(const ValueList& params, EvalEnv& env);
         ValuePtr eval(const ValueList& params, EvalEnv& env);
         ValuePtr exit(const ValueList& params, EvalEnv& env);
+        ValuePtr flushOutput(const ValueList& params, EvalEnv& env);
+        ValuePtr load(const ValueList& params, EvalEnv& env);
+        ValuePtr loadImage(const ValueList& params, EvalEnv& env);
         ValuePtr newline(const ValueList& params, EvalEnv& env);
+        ValuePtr printDepth(const ValueList& params, EvalEnv& env);
+        ValuePtr printLength(const ValueList& params, EvalEnv& env);
         ValuePtr read(const ValueList& params, EvalEnv& env);
+        ValuePtr isReadError(const ValueList& params, EvalEnv& env);
+        ValuePtr saveImage(const ValueList& params, EvalEnv& env);
+        ValuePtr write(const ValueList& params, EvalEnv& env);
+        ValuePtr writeShared(const ValueList& params, EvalEnv& env);
+        ValuePtr writeString(const ValueList& params, EvalEnv& env);
+    }
+
+    namespace Port
+    {
+        ValuePtr callWithInputFile(const ValueList& params, EvalEnv& env);
+        ValuePtr closePort(const ValueList& params, EvalEnv& env);
+        ValuePtr currentInputPort(const ValueList& params, EvalEnv& env);
+        ValuePtr currentOutputPort(const ValueList& params, EvalEnv& env);
+        ValuePtr deleteFile(const ValueList& params, EvalEnv& env);
+        ValuePtr eofObject(const ValueList& params, EvalEnv& env);
+        ValuePtr fileExists(const ValueList& params, EvalEnv& env);
+        ValuePtr forEachLine(const ValueList& params, EvalEnv& env);
+        ValuePtr forEachRecord(const ValueList& params, EvalEnv& env);
+        ValuePtr getOutputString(const ValueList& params, EvalEnv& env);
+        ValuePtr isInputPort(const ValueList& params, EvalEnv& env);
+        ValuePtr isOutputPort(const ValueList& params, EvalEnv& env);
+        ValuePtr openInputFile(const ValueList& params, EvalEnv& env);
+        ValuePtr openOutputFile(const ValueList& params, EvalEnv& env);
+        ValuePtr openOutputString(const ValueList& params, EvalEnv& env);
+        ValuePtr peekChar(const ValueList& params, EvalEnv& env);
+        ValuePtr readChar(const ValueList& params, EvalEnv& env);
+        ValuePtr readLine(const ValueList& params, EvalEnv& env);
+        ValuePtr withOutputToString(const ValueList& params, EvalEnv& env);
     }
 
     namespace TypeCheck
@@ -98,6 +139,7 @@ namespace Builtin
         ValuePtr map(const ValueList& params, EvalEnv& env);
         ValuePtr filter(const ValueList& params, EvalEnv& env);
         ValuePtr reduce(const ValueList& params, EvalEnv& env);
+        ValuePtr sort(const ValueList& params, EvalEnv& env);
     }
 
     namespace Math
@@ -113,6 +155,7 @@ namespace Builtin
         ValuePtr modulo(const ValueList& params, EvalEnv& env);
         ValuePtr gcd(const ValueList& params, EvalEnv& env);
         ValuePtr lcm(const ValueList& params, EvalEnv& env);
+        ValuePtr numberToString(const ValueList& params, EvalEnv& env);
     }
 
     namespace Compare
@@ -120,10 +163,11 @@ namespace Builtin
         ValuePtr eq(const ValueList& params, EvalEnv& env);
         ValuePtr equal(const ValueList& params, EvalEnv& env);
         ValuePtr _not(const ValueList& params, EvalEnv& env);
-        extern BuiltinFunc less;
-        extern BuiltinFunc more;
-        extern BuiltinFunc lessOrEqual;
-        extern BuiltinFunc moreOrEqual;
+        inline constexpr FuncType numEqual = compare<Number, isEqual<Number>, numberConv>;
+        inline constexpr FuncType less = compare<Number, std::less<Number>, numberConv>;
+        inline constexpr FuncType more = compare<Number, std::greater<Number>, numberConv>;
+        inline constexpr FuncType lessOrEqual = compare<Number, std::less_equal<Number>, numberConv>;
+        inline constexpr FuncType moreOrEqual = compare<Number, std::greater_equal<Number>, numberConv>;
         ValuePtr isEven(const ValueList& params, EvalEnv& env);
         ValuePtr isOdd(const ValueList& params, EvalEnv& env);
         ValuePtr isZero(const ValueList& params, EvalEnv& env);
@@ -131,16 +175,16 @@ namespace Builtin
 
     namespace Char
     {
-        extern BuiltinFunc charEqual;
-        extern BuiltinFunc charEqualCi;
-        extern BuiltinFunc charGreater;
-        extern BuiltinFunc charSmaller;
-        extern BuiltinFunc charGreaterOrEqual;
-        extern BuiltinFunc charSmallerOrEqual;
-        extern BuiltinFunc charGreaterCi;
-        extern BuiltinFunc charSmallerCi;
-        extern BuiltinFunc charGreaterOrEqualCi;
-        extern BuiltinFunc charSmallerOrEqualCi;
+        inline constexpr FuncType charEqual = compare<char, isEqual<char>, charConv>;
+        inline constexpr FuncType charEqualCi = compare<char, isEqual<char>, charCiConv>;
+        inline constexpr FuncType charGreater = compare<char, std::greater<char>, charConv>;
+        inline constexpr FuncType charSmaller = compare<char, std::less<char>, charConv>;
+        inline constexpr FuncType charGreaterOrEqual = compare<char, std::greater_equal<char>, charConv>;
+        inline constexpr FuncType charSmallerOrEqual = compare<char, std::less_equal<char>, charConv>;
+        inline constexpr FuncType charGreaterCi = compare<char, std::greater<char>, charCiConv>;
+        inline constexpr FuncType charSmallerCi = compare<char, std::less<char>, charCiConv>;
+        inline constexpr FuncType charGreaterOrEqualCi = compare<char, std::greater_equal<char>, charCiConv>;
+        inline constexpr FuncType charSmallerOrEqualCi = compare<char, std::less_equal<char>, charCiConv>;
         ValuePtr isCharAlphabetic(const ValueList& params, EvalEnv& env);
         ValuePtr isCharNumeric(const ValueList& params, EvalEnv& env);
         ValuePtr isCharWhitespace(const ValueList& params, EvalEnv& env);
@@ -164,6 +208,60 @@ namespace Builtin
         ValuePtr vectorFill(const ValueList& params, EvalEnv& env);
     }
 
+    namespace F64Vector
+    {
+        ValuePtr makeF64Vector(const ValueList& params, EvalEnv& env);
+        ValuePtr _f64vector(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorLength(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorRef(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorSet(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorToList(const ValueList& params, EvalEnv& env);
+        ValuePtr listToF64vector(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorToVector(const ValueList& params, EvalEnv& env);
+        ValuePtr vectorToF64vector(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorAdd(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorScale(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorDot(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorSum(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorMin(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorMax(const ValueList& params, EvalEnv& env);
+        ValuePtr f64vectorMap(const ValueList& params, EvalEnv& env);
+    }
+
+    namespace Matrix
+    {
+        ValuePtr makeMatrix(const ValueList& params, EvalEnv& env);
+        ValuePtr matrixRows(const ValueList& params, EvalEnv& env);
+        ValuePtr matrixCols(const ValueList& params, EvalEnv& env);
+        ValuePtr matrixRef(const ValueList& params, EvalEnv& env);
+        ValuePtr matrixSet(const ValueList& params, EvalEnv& env);
+        ValuePtr matrixAdd(const ValueList& params, EvalEnv& env);
+        ValuePtr matrixMul(const ValueList& params, EvalEnv& env);
+        ValuePtr matrixTranspose(const ValueList& params, EvalEnv& env);
+        ValuePtr matrixRow(const ValueList& params, EvalEnv& env);
+        ValuePtr matrixColumn(const ValueList& params, EvalEnv& env);
+        ValuePtr listToMatrix(const ValueList& params, EvalEnv& env);
+        ValuePtr matrixToList(const ValueList& params, EvalEnv& env);
+    }
+
+    namespace Bytevector
+    {
+        ValuePtr makeBytevector(const ValueList& params, EvalEnv& env);
+        ValuePtr _bytevector(const ValueList& params, EvalEnv& env);
+        ValuePtr bytevectorLength(const ValueList& params, EvalEnv& env);
+        ValuePtr bytevectorU8Ref(const ValueList& params, EvalEnv& env);
+        ValuePtr bytevectorU8Set(const ValueList& params, EvalEnv& env);
+        ValuePtr bytevectorCopy(const ValueList& params, EvalEnv& env);
+        ValuePtr bytevectorCopyInto(const ValueList& params, EvalEnv& env);
+        ValuePtr bytevectorFill(const ValueList& params, EvalEnv& env);
+        ValuePtr bytevectorU32Ref(const ValueList& params, EvalEnv& env);
+        ValuePtr bytevectorU32Set(const ValueList& params, EvalEnv& env);
+        ValuePtr bytevectorF64Ref(const ValueList& params, EvalEnv& env);
+        ValuePtr bytevectorF64Set(const ValueList& params, EvalEnv& env);
+        ValuePtr readBytevector(const ValueList& params, EvalEnv& env);
+        ValuePtr writeBytevector(const ValueList& params, EvalEnv& env);
+    }
+
     namespace String
     {
         ValuePtr makeString(const ValueList& params, EvalEnv& env);
@@ -171,22 +269,29 @@ namespace Builtin
         ValuePtr stringLength(const ValueList& params, EvalEnv& env);
         ValuePtr stringRef(const ValueList& params, EvalEnv& env);
         ValuePtr stringSet(const ValueList& params, EvalEnv& env);
-        extern BuiltinFunc stringEqual;
-        extern BuiltinFunc stringEqualCi;
-        extern BuiltinFunc stringGreater;
-        extern BuiltinFunc stringSmaller;
-        extern BuiltinFunc stringGreaterOrEqual;
-        extern BuiltinFunc stringSmallerOrEqual;
-        extern BuiltinFunc stringGreaterCi;
-        extern BuiltinFunc stringSmallerCi;
-        extern BuiltinFunc stringGreaterOrEqualCi;
-        extern BuiltinFunc stringSmallerOrEqualCi;
+        inline constexpr FuncType stringEqual = compare<std::string_view, isEqual<std::string_view>, stringViewConv>;
+        inline constexpr FuncType stringEqualCi = compare<CiString, isEqual<CiString>, stringCiConv>;
+        inline constexpr FuncType stringGreater = compare<std::string_view, std::greater<std::string_view>, stringViewConv>;
+        inline constexpr FuncType stringSmaller = compare<std::string_view, std::less<std::string_view>, stringViewConv>;
+        inline constexpr FuncType stringGreaterOrEqual = compare<std::string_view, std::greater_equal<std::string_view>, stringViewConv>;
+        inline constexpr FuncType stringSmallerOrEqual = compare<std::string_view, std::less_equal<std::string_view>, stringViewConv>;
+        inline constexpr FuncType stringGreaterCi = compare<CiString, std::greater<CiString>, stringCiConv>;
+        inline constexpr FuncType stringSmallerCi = compare<CiString, std::less<CiString>, stringCiConv>;
+        inline constexpr FuncType stringGreaterOrEqualCi = compare<CiString, std::greater_equal<CiString>, stringCiConv>;
+        inline constexpr FuncType stringSmallerOrEqualCi = compare<CiString, std::less_equal<CiString>, stringCiConv>;
         ValuePtr subString(const ValueList& params, EvalEnv& env);
         ValuePtr stringAppend(const ValueList& params, EvalEnv& env);
         ValuePtr listToString(const ValueList& params, EvalEnv& env);
         ValuePtr stringToList(const ValueList& params, EvalEnv& env);
         ValuePtr stringCopy(const ValueList& params, EvalEnv& env);
         ValuePtr stringFill(const ValueList& params, EvalEnv& env);
+        ValuePtr stringContains(const ValueList& params, EvalEnv& env);
+        ValuePtr stringIndex(const ValueList& params, EvalEnv& env);
+        ValuePtr stringJoin(const ValueList& params, EvalEnv& env);
+        ValuePtr stringPrefix(const ValueList& params, EvalEnv& env);
+        ValuePtr stringSearch(const ValueList& params, EvalEnv& env);
+        ValuePtr stringSplit(const ValueList& params, EvalEnv& env);
+        ValuePtr stringSuffix(const ValueList& params, EvalEnv& env);
     }
 
     namespace Control
@@ -195,6 +300,12 @@ namespace Builtin
     }
 }
 
-extern unordered_map<string, CallablePtr> allBuiltins;
+namespace Builtin
+{
+    // The builtin procedure called name, or nullptr. Builtins live in static storage (registry.h).
+    CallablePtr find(std::string_view name);
+    // The name of a builtin procedure, or an empty view if value is not one.
+    std::string_view nameOf(const Value& value);
+}
 
 #endif // !BUILTINS_H
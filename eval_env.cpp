@@ -1,11 +1,7 @@
 #include "./eval_env.h"
 
 EvalEnv::EvalEnv(EnvPtr parent)
-    :pParent{parent}
-{
-    symbolTable.insert(allBuiltins.begin(), allBuiltins.end());
-    specialFormTable.insert(allSpecialForms.begin(), allSpecialForms.end());
-}
+    :pParent{parent} {}
 
 EnvPtr EvalEnv::createGlobal()
 {
@@ -22,32 +18,12 @@ EnvPtr EvalEnv::createChild(EnvPtr parent, vector<string> names, ValueList value
     return EnvPtr(pEnv);
 }
 
-pair<EnvPtr, FormPtr> EvalEnv::findForm(const string& name)
+EvalEnv& EvalEnv::global()
 {
-    EnvPtr currentEnv = shared_from_this();
-    pair<EnvPtr, FormPtr> result = { nullptr, nullptr };
-    while (currentEnv)
-    {
-        auto iter = currentEnv->specialFormTable.find(name);
-        if (iter != currentEnv->specialFormTable.end())
-        {
-            result.first = currentEnv;
-            result.second = iter->second;
-            break;
-        }
-        currentEnv = currentEnv->pParent;
-    }
-    return result;
-}
-
-FormPtr EvalEnv::getForm(const string& name)
-{
-    auto result = findForm(name);
-    if (result.second)
-        return result.second;
-    else
-        throw LispError("Variable " + name + " not defined.");
-    
+    EvalEnv* env = this;
+    while (env->pParent)
+        env = env->pParent.get();
+    return *env;
 }
 
 pair<EnvPtr, ValuePtr> EvalEnv::findVariable(const string& name)
@@ -63,8 +39,16 @@ pair<EnvPtr, ValuePtr> EvalEnv::findVariable(const string& name)
             result.second = iter->second;
             break;
         }
+        if (!currentEnv->pParent)
+            break;
         currentEnv = currentEnv->pParent;
     }
+    // Builtins are not copied into any environment; they belong to the global one unless redefined there.
+    if (!result.second)
+    {
+        if (auto builtin = Builtin::find(name))
+            result = { currentEnv, builtin };
+    }
     return result;
 }
 
@@ -109,14 +93,9 @@ ValuePtr EvalEnv::eval(ValuePtr expr)
     }
     else if (auto name = expr->asSymbol())
     {
-        try
-        {
-            return getForm(*name);
-        }
-        catch (LispError& e)
-        {
-            return getVariableValue(*name);
-        }
+        if (auto form = SpecialForm::find(*name))
+            return form;
+        return getVariableValue(*name);
     }
     else if (expr->isType(ValueType::VectorType))
     {
@@ -20,16 +20,17 @@ class EvalEnv
     :public enable_shared_from_this<EvalEnv>
 {
     EnvPtr pParent;
-    unordered_map<string, FormPtr> specialFormTable;
     unordered_map<string, ValuePtr> symbolTable;
+    friend class ImageWriter;
+    friend class ImageReader;
     EvalEnv(EnvPtr parent);
 public:
     EvalEnv(const EvalEnv&) = delete;
     EvalEnv& operator=(const EvalEnv&) = delete;
     static EnvPtr createGlobal();
     static EnvPtr createChild(EnvPtr parent, vector<string> names = {}, ValueList values = {});
-    pair<EnvPtr, FormPtr> findForm(const string& name);
-    FormPtr getForm(const string& name);
+    // The global environment this one is nested in, or itself if it is the global one.
+    EvalEnv& global();
     pair<EnvPtr, ValuePtr> findVariable(const string& name);
     ValuePtr getVariableValue(const string& name);
     void defineVariable(const string& name, ValuePtr value);
@@ -0,0 +1,393 @@
+#include "./fasl.h"
+
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+namespace
+{
+    // Layout: the magic, then the fields of Header as little-endian 64-bit words, then the body: each
+    // top-level form encoded as a tagged datum.
+    constexpr char Magic[8] = { 'M', 'L', 'F', 'A', 'S', 'L', '0', '2' };
+
+    struct Header
+    {
+        uint64_t sourceSize;
+        uint64_t sourceHash;
+        uint64_t bodySize;
+        uint64_t bodyHash;
+    };
+    constexpr size_t HeaderSize = sizeof(Magic) + 4 * 8;
+
+    enum class Tag : uint8_t
+    {
+        Nil,
+        False,
+        True,
+        Fixnum,     // zigzag varint
+        Flonum,     // IEEE bits, 8 bytes
+        Bignum,     // varint length, then hexadecimal digits
+        String,     // varint length, then bytes
+        Char,       // 1 byte
+        SymbolDef,  // varint length, then the name; takes the next symbol index
+        SymbolRef,  // varint index
+        List,       // varint count > 0, the elements, then the tail datum
+        Vector      // varint count, then the elements
+    };
+
+    // Hashes a whole mapped file, letting go of its pages as it goes so a large source is not kept resident.
+    uint64_t hashFile(MappedFile& file)
+    {
+        constexpr size_t Slice = 1 << 20;
+        auto bytes = file.view();
+        uint64_t hash = 0;
+        for (size_t start = 0; start < bytes.size(); start += Slice)
+        {
+            hash = hash * 31 + Fasl::hashBytes(bytes.substr(start, Slice));
+            file.release(start + Slice);
+        }
+        return hash;
+    }
+
+    class Encoder
+    {
+        std::string& out;
+        // Parsed symbols are interned, so the object identifies the name.
+        std::unordered_map<const Value*, uint64_t> symbols;
+
+        void putTag(Tag tag) { out.push_back(static_cast<char>(tag)); }
+    public:
+        Encoder(std::string& out)
+            :out{ out } {}
+
+        void putDatum(const Value& value)
+        {
+            if (value.isType(ValueType::NilType))
+            {
+                putTag(Tag::Nil);
+            }
+            else if (value.isType(ValueType::BooleanType))
+            {
+                putTag(value.toString() == "#t" ? Tag::True : Tag::False);
+            }
+            else if (value.isType(ValueType::NumericType))
+            {
+                Fasl::putNumber(out, static_cast<const NumericValue&>(value).value());
+            }
+            else if (value.isType(ValueType::StringType))
+            {
+                putTag(Tag::String);
+                Fasl::putText(out, static_cast<const StringValue&>(value).value());
+            }
+            else if (value.isType(ValueType::CharType))
+            {
+                putTag(Tag::Char);
+                out.push_back(static_cast<const CharValue&>(value).value());
+            }
+            else if (value.isType(ValueType::SymbolType))
+            {
+                auto [it, isNew] = symbols.try_emplace(&value, symbols.size());
+                putTag(isNew ? Tag::SymbolDef : Tag::SymbolRef);
+                if (isNew)
+                    Fasl::putText(out, value.toString());
+                else
+                    Fasl::putVarint(out, it->second);
+            }
+            else if (value.isType(ValueType::PairType))
+            {
+                // Elements are written in a loop, so only nesting depth costs stack.
+                std::vector<const Value*> elements;
+                const Value* rest = &value;
+                while (rest->isType(ValueType::PairType))
+                {
+                    auto& pair = static_cast<const PairValue&>(*rest);
+                    elements.push_back(pair.left().get());
+                    rest = pair.right().get();
+                }
+                putTag(Tag::List);
+                Fasl::putVarint(out, elements.size());
+                for (auto element : elements)
+                    putDatum(*element);
+                putDatum(*rest);
+            }
+            else if (value.isType(ValueType::VectorType))
+            {
+                auto& elements = const_cast<VectorValue&>(static_cast<const VectorValue&>(value)).value();
+                putTag(Tag::Vector);
+                Fasl::putVarint(out, elements.size());
+                for (auto& element : elements)
+                    putDatum(*element);
+            }
+            else
+            {
+                throw InterpreterError("Cannot compile " + value.toString());
+            }
+        }
+    };
+
+    [[noreturn]] void corrupt()
+    {
+        throw InterpreterError("Corrupt FASL or image file");
+    }
+
+    // The number of a Fixnum, Flonum or Bignum tag already read.
+    Number readNumberAfter(Fasl::Input& input, Tag tag)
+    {
+        switch (tag)
+        {
+        case Tag::Fixnum:
+        {
+            uint64_t n = input.readVarint();
+            return static_cast<long long>((n >> 1) ^ (~(n & 1) + 1));
+        }
+        case Tag::Flonum:
+            return std::bit_cast<double>(input.readWord());
+        case Tag::Bignum:
+            if (auto number = Number::fromString(input.readText(), 16))
+                return std::move(*number);
+            corrupt();
+        default:
+            corrupt();
+        }
+    }
+}
+
+// FNV-1a over 64-bit words, with the trailing bytes folded into one last word. Word steps make it
+// cheap enough to check a large source at every start. The multiply only carries bits upward, so each
+// step also folds the high half back into the low half, and the result goes through the MurmurHash3
+// finalizer; without them, edits confined to the top byte of two words collide one time in 256.
+uint64_t Fasl::hashBytes(std::string_view bytes)
+{
+    constexpr uint64_t Prime = 0x100000001b3ull;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t i = 0;
+    for (; i + 8 <= bytes.size(); i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i, 8);
+        hash = (hash ^ word) * Prime;
+        hash ^= hash >> 32;
+    }
+    uint64_t last = bytes.size();
+    for (size_t shift = 8; i < bytes.size(); i++, shift += 8)
+        last ^= uint64_t(static_cast<unsigned char>(bytes[i])) << (shift % 64);
+    hash = (hash ^ last) * Prime;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    return hash ^ (hash >> 33);
+}
+
+void Fasl::putWord(std::string& out, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+        out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+void Fasl::putVarint(std::string& out, uint64_t value)
+{
+    for (; value >= 0x80; value >>= 7)
+        out.push_back(static_cast<char>(value | 0x80));
+    out.push_back(static_cast<char>(value));
+}
+
+void Fasl::putText(std::string& out, std::string_view text)
+{
+    putVarint(out, text.size());
+    out.append(text);
+}
+
+void Fasl::putNumber(std::string& out, const Number& number)
+{
+    if (number.isFixnum())
+    {
+        auto n = static_cast<uint64_t>(number.fixnum());
+        out.push_back(static_cast<char>(Tag::Fixnum));
+        putVarint(out, (n << 1) ^ (number.isNegative() ? ~uint64_t(0) : 0));
+    }
+    else if (!number.isExact())
+    {
+        out.push_back(static_cast<char>(Tag::Flonum));
+        putWord(out, std::bit_cast<uint64_t>(number.toDouble()));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(Tag::Bignum));
+        putText(out, number.toString(16));
+    }
+}
+
+uint8_t Fasl::Input::readByte()
+{
+    return static_cast<uint8_t>(readBytes(1)[0]);
+}
+
+uint64_t Fasl::Input::readWord()
+{
+    const char* data = readBytes(8).data();
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+        value |= uint64_t(static_cast<unsigned char>(data[i])) << (8 * i);
+    return value;
+}
+
+uint64_t Fasl::Input::readVarint()
+{
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        uint8_t byte = readByte();
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+    corrupt();
+}
+
+std::string_view Fasl::Input::readBytes(size_t count)
+{
+    if (count > bytes.size() - pos)
+        corrupt();
+    pos += count;
+    return bytes.substr(pos - count, count);
+}
+
+std::string_view Fasl::Input::readText()
+{
+    return readBytes(readVarint());
+}
+
+Number Fasl::Input::readNumber()
+{
+    return readNumberAfter(*this, static_cast<Tag>(readByte()));
+}
+
+std::string Fasl::cachePath(const std::string& sourcePath)
+{
+    return std::filesystem::path(sourcePath).replace_extension(".fasl").string();
+}
+
+void Fasl::compile(const std::string& sourcePath)
+{
+    auto source = MappedFile::open(sourcePath);
+    if (!source)
+        throw InterpreterError("Cannot compile \"" + sourcePath + "\": not a non-empty regular file");
+
+    std::string body;
+    Encoder encoder(body);
+    PrefetchReader reader(sourcePath);
+    while (auto value = reader.next())
+        encoder.putDatum(*value);
+
+    std::string header(Magic, sizeof(Magic));
+    putWord(header, source->view().size());
+    putWord(header, hashFile(*source));
+    putWord(header, body.size());
+    putWord(header, hashBytes(body));
+
+    // Written aside and renamed into place, so a reader never sees a half-written cache.
+    auto target = cachePath(sourcePath);
+    auto temporary = target + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(header.data(), header.size());
+        out.write(body.data(), body.size());
+        if (!out.flush())
+            throw InterpreterError("Write \"" + temporary + "\" failed");
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+    if (error)
+        throw InterpreterError("Write \"" + target + "\" failed: " + error.message());
+}
+
+shared_ptr<FormReader> Fasl::openForms(const std::string& sourcePath)
+{
+    if (auto cached = FaslReader::open(sourcePath))
+        return cached;
+    return make_shared<PrefetchReader>(sourcePath);
+}
+
+shared_ptr<FaslReader> FaslReader::open(const std::string& sourcePath)
+{
+    auto cache = MappedFile::open(Fasl::cachePath(sourcePath));
+    if (!cache || cache->view().size() < HeaderSize || std::memcmp(cache->view().data(), Magic, sizeof(Magic)) != 0)
+        return nullptr;
+    Fasl::Input fields{ cache->view(), sizeof(Magic) };
+    Header header{ fields.readWord(), fields.readWord(), fields.readWord(), fields.readWord() };
+    auto body = cache->view().substr(HeaderSize);
+    if (header.bodySize != body.size() || header.bodyHash != Fasl::hashBytes(body))
+        return nullptr;
+
+    auto source = MappedFile::open(sourcePath);
+    if (!source || header.sourceSize != source->view().size() || header.sourceHash != hashFile(*source))
+        return nullptr;
+    return shared_ptr<FaslReader>(new FaslReader(std::move(cache), HeaderSize));
+}
+
+ValuePtr FaslReader::next()
+{
+    if (input.isAtEnd())
+        return nullptr;
+    auto value = readDatum();
+    file->release(input.pos);
+    return value;
+}
+
+ValuePtr FaslReader::readDatum()
+{
+    auto tag = static_cast<Tag>(input.readByte());
+    switch (tag)
+    {
+    case Tag::Nil:
+        return make_shared<NilValue>();
+    case Tag::False:
+        return make_shared<BooleanValue>(false);
+    case Tag::True:
+        return make_shared<BooleanValue>(true);
+    case Tag::Fixnum:
+    case Tag::Flonum:
+    case Tag::Bignum:
+        return make_shared<NumericValue>(readNumberAfter(input, tag));
+    case Tag::String:
+        return make_shared<StringValue>(string(input.readText()));
+    case Tag::Char:
+        return make_shared<CharValue>(static_cast<char>(input.readByte()));
+    case Tag::SymbolDef:
+    {
+        symbols.push_back(SymbolValue::intern(input.readText()));
+        return symbols.back();
+    }
+    case Tag::SymbolRef:
+    {
+        uint64_t index = input.readVarint();
+        if (index >= symbols.size())
+            corrupt();
+        return symbols[index];
+    }
+    case Tag::List:
+    {
+        ListBuilder builder;
+        for (uint64_t count = input.readVarint(); count > 0; count--)
+            builder.append(readDatum());
+        if (builder.isEmpty())
+            corrupt();
+        auto rest = readDatum();
+        if (!rest->isType(ValueType::NilType))
+            builder.setRest(std::move(rest));
+        return builder.release();
+    }
+    case Tag::Vector:
+    {
+        ValueList elements;
+        for (uint64_t count = input.readVarint(); count > 0; count--)
+            elements.push_back(readDatum());
+        return make_shared<VectorValue>(std::move(elements));
+    }
+    default:
+        corrupt();
+    }
+}
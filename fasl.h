@@ -0,0 +1,68 @@
+#ifndef FASL_H
+#define FASL_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./value.h"
+#include "./reader.h"
+#include "./mapped_file.h"
+
+// A binary cache of a source file's parsed forms, stored next to it as <name>.fasl. Loading it skips
+// tokenizing and parsing. Its header records the size and hash of the source it was compiled from, so
+// a cache that no longer matches is ignored and the source is parsed as usual.
+namespace Fasl
+{
+    std::string cachePath(const std::string& sourcePath);
+    // Parses sourcePath and writes its cache, replacing any previous one.
+    void compile(const std::string& sourcePath);
+    // The forms of sourcePath, for running it: decoded from its cache if that is fresh, otherwise parsed.
+    shared_ptr<FormReader> openForms(const std::string& sourcePath);
+
+    // Primitives of the binary encoding, shared with heap images (image.h).
+    uint64_t hashBytes(std::string_view bytes);
+    void putWord(std::string& out, uint64_t value);
+    void putVarint(std::string& out, uint64_t value);
+    // A varint length, then the bytes.
+    void putText(std::string& out, std::string_view text);
+    // A tag byte for the representation, then the number.
+    void putNumber(std::string& out, const Number& number);
+
+    // Reads the primitives back, advancing pos. Running past the end or malformed data throws InterpreterError.
+    struct Input
+    {
+        std::string_view bytes;
+        size_t pos;
+
+        bool isAtEnd() const { return pos == bytes.size(); }
+        uint8_t readByte();
+        uint64_t readWord();
+        uint64_t readVarint();
+        std::string_view readBytes(size_t count);
+        std::string_view readText();
+        Number readNumber();
+    };
+}
+
+// Decodes the forms of a fresh cache one at a time, straight from the mapped file.
+class FaslReader
+    :public FormReader
+{
+    shared_ptr<MappedFile> file;
+    Fasl::Input input;
+    // Symbols in order of first appearance; later appearances refer to them by index.
+    std::vector<ValuePtr> symbols;
+
+    FaslReader(shared_ptr<MappedFile> file, size_t bodyStart)
+        :file{ std::move(file) }, input{ this->file->view(), bodyStart } {}
+    ValuePtr readDatum();
+public:
+    // The cached forms of sourcePath, or nullptr if it has no cache or the cache does not match it.
+    static shared_ptr<FaslReader> open(const std::string& sourcePath);
+    ValuePtr next() override;
+};
+
+#endif // !FASL_H
@@ -1,15 +1,13 @@
 #include "forms.h"
 #include "eval_env.h"
+#include "registry.h"
+
+#include <exception>
 
 namespace SpecialForm
 {
     namespace Helper
     {
-        pair<string, shared_ptr<SpecialFormValue>> SpecialFormItem(string name, FuncType func, int minArgs, int maxArgs, const vector<int>& paramType)
-        {
-            return make_pair(name, make_shared <SpecialFormValue> (func, minArgs, maxArgs, paramType));
-        }
-
         bool defineVariable(const ValueList& params, EvalEnv& defineEnv, EvalEnv& evalEnv)
         {
             if (auto name = params[0]->asSymbol())
@@ -325,28 +323,93 @@ namespace SpecialForm
         {
             return make_shared<PromiseValue>(params[0]);
         }
+
+        // (guard (var clause ...) body ...) evaluates body; if that raises an error, var is bound to an
+        // error object and the clauses are tried as in cond. An error no clause accepts is raised again.
+        ValuePtr guardForm(const ValueList& params, EvalEnv& env)
+        {
+            auto spec = params[0]->toVector();
+            SpecialFormValue::assertParamCnt(spec, 1);
+            auto name = spec[0]->asSymbol();
+            if (!name)
+                throw LispError("Expect symbol in guard, found " + spec[0]->toString());
+            std::exception_ptr caught;
+            ValuePtr error;
+            try
+            {
+                auto bodyEnv = EvalEnv::createChild(env.shared_from_this());
+                ValuePtr result = make_shared<NilValue>();
+                for (size_t i = 1; i < params.size(); i++)
+                    result = bodyEnv->eval(params[i]);
+                return result;
+            }
+            catch (LispError& e)
+            {
+                caught = std::current_exception();
+                error = make_shared<ErrorValue>(ErrorValue::Kind::Lisp, e.what());
+            }
+            catch (SyntaxError& e)
+            {
+                caught = std::current_exception();
+                error = make_shared<ErrorValue>(ErrorValue::Kind::Syntax, e.what());
+            }
+            catch (InterpreterError& e)
+            {
+                caught = std::current_exception();
+                error = make_shared<ErrorValue>(ErrorValue::Kind::Interpreter, e.what());
+            }
+
+            auto handlerEnv = EvalEnv::createChild(env.shared_from_this(), { *name, "else" }, { error, make_shared<BooleanValue>(true) });
+            for (size_t i = 1; i < spec.size(); i++)
+            {
+                auto clause = spec[i]->toVector();
+                SpecialFormValue::assertParamCnt(clause, 1);
+                auto result = handlerEnv->eval(clause[0]);
+                if (!*result)
+                    continue;
+                for (size_t j = 1; j < clause.size(); j++)
+                    result = handlerEnv->eval(clause[j]);
+                return result;
+            }
+            std::rethrow_exception(caught);
+        }
     }
 }
 
 using namespace SpecialForm::Helper;
 using namespace std::literals;
 
-const unordered_map<string, FormPtr> allSpecialForms =
+namespace
 {
-    SpecialFormItem("lambda"s, SpecialForm::Primary::lambdaForm, 2, CallableValue::UnlimitedCnt, {ValueType::ListType}),
-    SpecialFormItem("define"s, SpecialForm::Primary::defineForm, 2, CallableValue::UnlimitedCnt, {ValueType::AllType}),
-    SpecialFormItem("quote"s, SpecialForm::Primary::quoteForm, 1, 1),
-    SpecialFormItem("if"s, SpecialForm::Primary::ifForm, 2, 3),
-    SpecialFormItem("set!"s, SpecialForm::Primary::setForm, 2, 2, {ValueType::SymbolType, ValueType::AllType}),
-    SpecialFormItem("cond"s, SpecialForm::Derived::condForm, CallableValue::UnlimitedCnt, CallableValue::UnlimitedCnt, {ValueType::ListType, CallableValue::SameToRest}),
-    SpecialFormItem("let"s, SpecialForm::Derived::letForm, 2),
-    SpecialFormItem("let*"s, SpecialForm::Derived::letxForm, 2),
-    SpecialFormItem("letrec"s, SpecialForm::Derived::letrecForm, 2),
-    SpecialFormItem("begin"s, SpecialForm::Derived::beginForm, 1),
-    SpecialFormItem("and"s, SpecialForm::Derived::andForm),
-    SpecialFormItem("or"s, SpecialForm::Derived::orForm),
-    SpecialFormItem("do"s, SpecialForm::Derived::doForm, 2, CallableValue::UnlimitedCnt, {ValueType::ListType, ValueType::ListType}),
-    SpecialFormItem("quasiquote"s, SpecialForm::Derived::quasiquoteForm, 1, 1),
-    SpecialFormItem("delay"s, SpecialForm::Derived::delayForm, 1, 1),
-};
+    constexpr ProcSpec specialFormSpecs[] =
+    {
+        { "lambda", SpecialForm::Primary::lambdaForm, 2, CallableValue::UnlimitedCnt, paramTypes<ValueType::ListType> },
+        { "define", SpecialForm::Primary::defineForm, 2, CallableValue::UnlimitedCnt, paramTypes<ValueType::AllType> },
+        { "quote", SpecialForm::Primary::quoteForm, 1, 1 },
+        { "if", SpecialForm::Primary::ifForm, 2, 3 },
+        { "set!", SpecialForm::Primary::setForm, 2, 2, paramTypes<ValueType::SymbolType, ValueType::AllType> },
+        { "cond", SpecialForm::Derived::condForm, CallableValue::UnlimitedCnt, CallableValue::UnlimitedCnt, paramTypes<ValueType::ListType, CallableValue::SameToRest> },
+        { "let", SpecialForm::Derived::letForm, 2 },
+        { "let*", SpecialForm::Derived::letxForm, 2 },
+        { "letrec", SpecialForm::Derived::letrecForm, 2 },
+        { "begin", SpecialForm::Derived::beginForm, 1 },
+        { "and", SpecialForm::Derived::andForm },
+        { "or", SpecialForm::Derived::orForm },
+        { "do", SpecialForm::Derived::doForm, 2, CallableValue::UnlimitedCnt, paramTypes<ValueType::ListType, ValueType::ListType> },
+        { "quasiquote", SpecialForm::Derived::quasiquoteForm, 1, 1 },
+        { "delay", SpecialForm::Derived::delayForm, 1, 1 },
+        { "guard", SpecialForm::Derived::guardForm, 1, CallableValue::UnlimitedCnt, paramTypes<ValueType::PairType> },
+    };
 
+    constinit Registry<SpecialFormValue, std::size(specialFormSpecs)> specialFormRegistry{ specialFormSpecs };
+}
+
+FormPtr SpecialForm::find(std::string_view name)
+{
+    return specialFormRegistry.find(name);
+}
+
+std::string_view SpecialForm::nameOf(const Value& value)
+{
+    return specialFormRegistry.nameOf(value);
+}
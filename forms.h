@@ -16,13 +16,6 @@ namespace SpecialForm
 {
     namespace Helper
     {
-        pair<string, shared_ptr<SpecialFormValue>> SpecialFormItem(
-            string name,
-            FuncType func,
-            int minArgs = CallableValue::UnlimitedCnt,
-            int maxArgs = CallableValue::UnlimitedCnt,
-            const vector<int>& paramType = CallableValue::UnlimitedType
-        );
         bool defineVariable(const ValueList& params, EvalEnv& defineEnv, EvalEnv& evalEnv);
         void defineVariableAndAssert(const ValueList& params, EvalEnv& defineEnv, EvalEnv& evalEnv);
         ValuePtr basicLet(const ValueList& params, EvalEnv& env, function<void(const ValueList&, EvalEnv&, EvalEnv&)> defineOrder);
@@ -56,10 +49,17 @@ namespace SpecialForm
         ValuePtr quasiquoteForm(const ValueList& params, EvalEnv& env);
         ValuePtr unquoteForm(const ValueList& params, EvalEnv& env);
         ValuePtr delayForm(const ValueList& params, EvalEnv& env);
+        ValuePtr guardForm(const ValueList& params, EvalEnv& env);
     }
 }
 
-extern const unordered_map<string, FormPtr> allSpecialForms;
+namespace SpecialForm
+{
+    // The special form called name, or nullptr. Special forms live in static storage (registry.h).
+    FormPtr find(std::string_view name);
+    // The name of a special form, or an empty view if value is not one.
+    std::string_view nameOf(const Value& value);
+}
 
 #endif // !FORMS_H
 
@@ -0,0 +1,445 @@
+#include "./image.h"
+#include "./fasl.h"
+#include "./mapped_file.h"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Layout: the magic, the body size and body hash as little-endian 64-bit words, then the body: the
+    // object count, every object's Kind and contents in index order, and finally the references of every
+    // object in the same order, as varint indices. Object 0 is the global environment. Version 2 has
+    // the body hash with full avalanche (Fasl::hashBytes).
+    constexpr char Magic[8] = { 'M', 'L', 'I', 'M', 'A', 'G', 'E', '2' };
+    constexpr size_t HeaderSize = sizeof(Magic) + 2 * 8;
+
+    enum class Kind : uint8_t
+    {
+        Global,         // binding count, the names; refs: the values
+        Env,            // binding count, the names; refs: the parent, the values
+        Nil,
+        False,
+        True,
+        Number,         // as Fasl::putNumber
+        String,         // text
+        Char,           // 1 byte
+        Symbol,         // text
+        Pair,           // refs: car, cdr
+        Vector,         // count; refs: the elements
+        F64Vector,      // count, then the elements as IEEE bits
+        Matrix,         // rows, cols, then the elements as IEEE bits
+        Bytevector,     // text
+        Builtin,        // name
+        SpecialForm,    // name
+        Lambda,         // parameter count, the names, body length; refs: the environment, the body
+        Promise         // 1 if evaluated; refs: the expression or value
+    };
+
+    [[noreturn]] void corrupt()
+    {
+        throw InterpreterError("Corrupt image file");
+    }
+}
+
+class ImageWriter
+{
+    // Every object gets an index when it is first referenced, and is written when its turn comes, so
+    // deep or circular structure needs no recursion.
+    std::unordered_map<const void*, uint64_t> indices;
+    std::vector<std::pair<const Value*, const EvalEnv*>> objects;
+    std::string contents;
+    std::string references;
+
+    uint64_t indexOf(const Value* value, const EvalEnv* env)
+    {
+        const void* key = value ? static_cast<const void*>(value) : env;
+        auto [it, isNew] = indices.try_emplace(key, objects.size());
+        if (isNew)
+            objects.emplace_back(value, env);
+        return it->second;
+    }
+    void refer(const ValuePtr& value) { Fasl::putVarint(references, indexOf(value.get(), nullptr)); }
+    void refer(const EnvPtr& env) { Fasl::putVarint(references, indexOf(nullptr, env.get())); }
+    void putKind(Kind kind) { contents.push_back(static_cast<char>(kind)); }
+    void putDoubles(const vector<double>& values)
+    {
+        for (double value : values)
+            Fasl::putWord(contents, std::bit_cast<uint64_t>(value));
+    }
+
+    void putEnv(const EvalEnv& env, bool isGlobal)
+    {
+        vector<std::pair<const string*, const ValuePtr*>> bindings;
+        for (auto& [name, value] : env.symbolTable)
+            bindings.emplace_back(&name, &value);
+        putKind(isGlobal ? Kind::Global : Kind::Env);
+        Fasl::putVarint(contents, bindings.size());
+        for (auto [name, value] : bindings)
+            Fasl::putText(contents, *name);
+        if (!isGlobal)
+            refer(env.pParent);
+        for (auto [name, value] : bindings)
+            refer(*value);
+    }
+
+    void putValue(const Value& value)
+    {
+        switch (value.getTypeID())
+        {
+        case ValueType::NilType:
+            putKind(Kind::Nil);
+            break;
+        case ValueType::BooleanType:
+            putKind(value.toString() == "#t" ? Kind::True : Kind::False);
+            break;
+        case ValueType::NumericType:
+            putKind(Kind::Number);
+            Fasl::putNumber(contents, static_cast<const NumericValue&>(value).value());
+            break;
+        case ValueType::StringType:
+            putKind(Kind::String);
+            Fasl::putText(contents, static_cast<const StringValue&>(value).value());
+            break;
+        case ValueType::CharType:
+            putKind(Kind::Char);
+            contents.push_back(static_cast<const CharValue&>(value).value());
+            break;
+        case ValueType::SymbolType:
+            putKind(Kind::Symbol);
+            Fasl::putText(contents, value.toString());
+            break;
+        case ValueType::PairType:
+        {
+            auto& pair = static_cast<const PairValue&>(value);
+            putKind(Kind::Pair);
+            refer(pair.left());
+            refer(pair.right());
+            break;
+        }
+        case ValueType::VectorType:
+        {
+            auto& elements = const_cast<VectorValue&>(static_cast<const VectorValue&>(value)).value();
+            putKind(Kind::Vector);
+            Fasl::putVarint(contents, elements.size());
+            for (auto& element : elements)
+                refer(element);
+            break;
+        }
+        case ValueType::F64VectorType:
+        {
+            auto& elements = const_cast<F64VectorValue&>(static_cast<const F64VectorValue&>(value)).value();
+            putKind(Kind::F64Vector);
+            Fasl::putVarint(contents, elements.size());
+            putDoubles(elements);
+            break;
+        }
+        case ValueType::MatrixType:
+        {
+            auto& matrix = const_cast<MatrixValue&>(static_cast<const MatrixValue&>(value));
+            putKind(Kind::Matrix);
+            Fasl::putVarint(contents, matrix.rows());
+            Fasl::putVarint(contents, matrix.cols());
+            putDoubles(matrix.value());
+            break;
+        }
+        case ValueType::BytevectorType:
+        {
+            auto& bytes = const_cast<BytevectorValue&>(static_cast<const BytevectorValue&>(value)).value();
+            putKind(Kind::Bytevector);
+            Fasl::putText(contents, { reinterpret_cast<const char*>(bytes.data()), bytes.size() });
+            break;
+        }
+        case ValueType::BuiltinProcType:
+        case ValueType::SpecialFormType:
+        {
+            // Primitives are native code: the image names them, and the loader looks them up again.
+            bool isBuiltin = value.isType(ValueType::BuiltinProcType);
+            auto name = isBuiltin ? Builtin::nameOf(value) : SpecialForm::nameOf(value);
+            if (name.empty())
+                throw LispError("Cannot save " + value.toString());
+            putKind(isBuiltin ? Kind::Builtin : Kind::SpecialForm);
+            Fasl::putText(contents, name);
+            break;
+        }
+        case ValueType::LambdaType:
+        {
+            auto& lambda = static_cast<const LambdaValue&>(value);
+            putKind(Kind::Lambda);
+            Fasl::putVarint(contents, lambda.paramNames.size());
+            for (auto& name : lambda.paramNames)
+                Fasl::putText(contents, name);
+            Fasl::putVarint(contents, lambda.body.size());
+            refer(lambda.parentEnv);
+            for (auto& expr : lambda.body)
+                refer(expr);
+            break;
+        }
+        case ValueType::PromiseType:
+        {
+            auto& promise = static_cast<const PromiseValue&>(value);
+            putKind(Kind::Promise);
+            contents.push_back(promise.isEvaluated);
+            refer(promise.value);
+            break;
+        }
+        default:
+            throw LispError("Cannot save " + value.toString());
+        }
+    }
+public:
+    // Writes the global environment of env.
+    ImageWriter(const EvalEnv& env)
+    {
+        const EvalEnv* global = &env;
+        while (global->pParent)
+            global = global->pParent.get();
+        indexOf(nullptr, global);
+    }
+
+    std::string write()
+    {
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            auto [value, env] = objects[i];
+            if (env)
+                putEnv(*env, i == 0);
+            else
+                putValue(*value);
+        }
+        std::string body;
+        Fasl::putVarint(body, objects.size());
+        body += contents;
+        body += references;
+        return body;
+    }
+};
+
+class ImageReader
+{
+    Fasl::Input input;
+    EvalEnv& global;
+    // Exactly one of these is set at each object index.
+    vector<ValuePtr> values;
+    vector<EnvPtr> envs;
+    // The binding names of the environment at each index.
+    vector<vector<string>> bindingNames;
+
+    // A count of things still to be read, each taking at least one byte, so a bad count cannot
+    // make the loader allocate more than the file could describe.
+    size_t readCount()
+    {
+        uint64_t count = input.readVarint();
+        if (count > input.bytes.size() - input.pos)
+            corrupt();
+        return count;
+    }
+    vector<double> readDoubles(size_t count)
+    {
+        if (count > (input.bytes.size() - input.pos) / 8)
+            corrupt();
+        vector<double> result(count);
+        for (auto& value : result)
+            value = std::bit_cast<double>(input.readWord());
+        return result;
+    }
+    template<typename Ptr>
+    static Ptr found(Ptr primitive)
+    {
+        if (!primitive)
+            corrupt();
+        return primitive;
+    }
+
+    ValuePtr readValue(Kind kind)
+    {
+        switch (kind)
+        {
+        case Kind::Nil:
+            return make_shared<NilValue>();
+        case Kind::False:
+            return make_shared<BooleanValue>(false);
+        case Kind::True:
+            return make_shared<BooleanValue>(true);
+        case Kind::Number:
+            return make_shared<NumericValue>(input.readNumber());
+        case Kind::String:
+            return make_shared<StringValue>(string(input.readText()));
+        case Kind::Char:
+            return make_shared<CharValue>(static_cast<char>(input.readByte()));
+        case Kind::Symbol:
+            return SymbolValue::intern(input.readText());
+        case Kind::Pair:
+            return make_shared<PairValue>(nullptr, nullptr);
+        case Kind::Vector:
+            return make_shared<VectorValue>(ValueList(readCount()));
+        case Kind::F64Vector:
+            return make_shared<F64VectorValue>(readDoubles(input.readVarint()));
+        case Kind::Matrix:
+        {
+            uint64_t rows = input.readVarint();
+            uint64_t cols = input.readVarint();
+            if (cols != 0 && rows > UINT64_MAX / cols)
+                corrupt();
+            return make_shared<MatrixValue>(rows, cols, readDoubles(rows * cols));
+        }
+        case Kind::Bytevector:
+        {
+            auto bytes = input.readText();
+            return make_shared<BytevectorValue>(vector<uint8_t>(bytes.begin(), bytes.end()));
+        }
+        case Kind::Builtin:
+            return found(Builtin::find(input.readText()));
+        case Kind::SpecialForm:
+            return found(SpecialForm::find(input.readText()));
+        case Kind::Lambda:
+        {
+            vector<string> params(readCount());
+            for (auto& name : params)
+                name = input.readText();
+            return make_shared<LambdaValue>(params, ValueList(readCount()), nullptr);
+        }
+        case Kind::Promise:
+        {
+            auto promise = make_shared<PromiseValue>(nullptr);
+            promise->isEvaluated = input.readByte() != 0;
+            return promise;
+        }
+        default:
+            corrupt();
+        }
+    }
+
+    ValuePtr valueAt(uint64_t index)
+    {
+        if (index >= values.size() || !values[index])
+            corrupt();
+        return values[index];
+    }
+    ValuePtr readValueRef() { return valueAt(input.readVarint()); }
+    EnvPtr readEnvRef()
+    {
+        uint64_t index = input.readVarint();
+        if (index >= envs.size() || !envs[index])
+            corrupt();
+        return envs[index];
+    }
+
+    void readReferences(size_t index, vector<std::pair<string, ValuePtr>>& globalBindings)
+    {
+        if (auto& env = envs[index])
+        {
+            if (index != 0)
+                env->pParent = readEnvRef();
+            for (auto& name : bindingNames[index])
+            {
+                auto value = readValueRef();
+                if (index == 0)
+                    globalBindings.emplace_back(name, std::move(value));
+                else
+                    env->symbolTable[name] = std::move(value);
+            }
+            return;
+        }
+        auto& value = values[index];
+        switch (value->getTypeID())
+        {
+        case ValueType::PairType:
+        {
+            auto& pair = static_cast<PairValue&>(*value);
+            pair.pLeftValue = readValueRef();
+            pair.pRightValue = readValueRef();
+            break;
+        }
+        case ValueType::VectorType:
+            for (auto& element : static_cast<VectorValue&>(*value).value())
+                element = readValueRef();
+            break;
+        case ValueType::LambdaType:
+        {
+            auto& lambda = static_cast<LambdaValue&>(*value);
+            lambda.parentEnv = readEnvRef();
+            for (auto& expr : lambda.body)
+                expr = readValueRef();
+            break;
+        }
+        case ValueType::PromiseType:
+            static_cast<PromiseValue&>(*value).value = readValueRef();
+            break;
+        }
+    }
+public:
+    ImageReader(std::string_view body, EvalEnv& global)
+        :input{ body, 0 }, global{ global } {}
+
+    void read()
+    {
+        size_t count = readCount();
+        if (count == 0)
+            corrupt();
+        values.resize(count);
+        envs.resize(count);
+        bindingNames.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            auto kind = static_cast<Kind>(input.readByte());
+            if ((kind == Kind::Global) != (i == 0))
+                corrupt();
+            if (kind == Kind::Global || kind == Kind::Env)
+            {
+                envs[i] = i == 0 ? global.shared_from_this() : EvalEnv::createChild(nullptr);
+                bindingNames[i].resize(readCount());
+                for (auto& name : bindingNames[i])
+                    name = input.readText();
+            }
+            else
+            {
+                values[i] = readValue(kind);
+            }
+        }
+
+        // The global definitions take effect only once the whole image has been read.
+        vector<std::pair<string, ValuePtr>> globalBindings;
+        for (size_t i = 0; i < count; i++)
+            readReferences(i, globalBindings);
+        if (!input.isAtEnd())
+            corrupt();
+        for (auto& [name, value] : globalBindings)
+            global.defineVariable(name, std::move(value));
+    }
+};
+
+void Image::save(EvalEnv& env, const std::string& fileName)
+{
+    std::string body = ImageWriter(env).write();
+
+    std::string header(Magic, sizeof(Magic));
+    Fasl::putWord(header, body.size());
+    Fasl::putWord(header, Fasl::hashBytes(body));
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        throw LispError("Open file \"" + fileName + "\" failed");
+    if (!file.write(header.data(), header.size()) || !file.write(body.data(), body.size()))
+        throw LispError("Write file \"" + fileName + "\" failed");
+}
+
+void Image::load(EvalEnv& global, const std::string& fileName)
+{
+    auto file = MappedFile::open(fileName);
+    if (!file)
+        throw InterpreterError("Open image \"" + fileName + "\" failed");
+    auto bytes = file->view();
+    if (bytes.size() < HeaderSize || std::memcmp(bytes.data(), Magic, sizeof(Magic)) != 0)
+        corrupt();
+    Fasl::Input header{ bytes, sizeof(Magic) };
+    uint64_t bodySize = header.readWord();
+    uint64_t bodyHash = header.readWord();
+    auto body = bytes.substr(HeaderSize);
+    if (bodySize != body.size() || bodyHash != Fasl::hashBytes(body))
+        corrupt();
+    ImageReader(body, global).read();
+}
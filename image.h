@@ -0,0 +1,22 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <string>
+
+#include "./value.h"
+#include "./eval_env.h"
+
+// A heap image: the definitions of a global environment and everything they reach, including closures,
+// the environments they captured, and shared or circular structure. Objects are numbered rather than
+// addressed, so an image loads anywhere: the loader allocates every object in one pass over the mapped
+// file, then fills in the references between them in a second.
+namespace Image
+{
+    // Writes the image of the global environment env belongs to. Throws LispError if the file cannot be
+    // written or a definition reaches a value that has no image form.
+    void save(EvalEnv& env, const std::string& fileName);
+    // Adds the definitions saved in fileName to global. Throws InterpreterError if it is not a valid image.
+    void load(EvalEnv& global, const std::string& fileName);
+}
+
+#endif // !IMAGE_H
@@ -24,37 +24,81 @@ Interpreter::Interpreter()
     globalEvalEnv = EvalEnv::createGlobal();
 }
 
-Interpreter::Interpreter(const string& fileName)
-    :mode{ InterpreterMode::FILEMODE }, exitCode{ 0 }
+Interpreter::Interpreter(const string& fileName, InterpreterMode mode)
+    :mode{ mode }, exitCode{ 0 }, fileName{ fileName }
 {
-    codeReader = make_shared<Reader>(fileName);
+    if (mode == InterpreterMode::FILEMODE)
+    {
+        // A fresh FASL cache next to the file spares parsing it; otherwise the source is parsed.
+        fileReader = Fasl::openForms(fileName);
+    }
     globalEvalEnv = EvalEnv::createGlobal();
 }
 
 shared_ptr<Interpreter> Interpreter::createInterpreter(int argc, const char** argv)
 {
+    const string usage = "Usage: mini-lisp [--image <image>] [<file>] | mini-lisp --compile <file>";
+    string imageName;
+    if (argc >= 2 && string(argv[1]) == "--image")
+    {
+        if (argc < 3)
+            throw InterpreterError(usage);
+        imageName = argv[2];
+        argc -= 2;
+        argv += 2;
+    }
+    shared_ptr<Interpreter> interpreter;
     if (argc == 1)
-        return shared_ptr<Interpreter>(new Interpreter);
+        interpreter.reset(new Interpreter);
+    else if (string(argv[1]) == "--compile")
+    {
+        if (argc != 3 || !imageName.empty())
+            throw InterpreterError(usage);
+        interpreter.reset(new Interpreter(argv[2], InterpreterMode::COMPILEMODE));
+    }
     else
-        return shared_ptr<Interpreter>(new Interpreter(argv[1]));
+        interpreter.reset(new Interpreter(argv[1], InterpreterMode::FILEMODE));
+    interpreter->imageName = imageName;
+    return interpreter;
 }
 
 int Interpreter::run()
 {
+    if (mode == InterpreterMode::COMPILEMODE)
+    {
+        Fasl::compile(fileName);
+        return exitCode;
+    }
+    if (!imageName.empty())
+        Image::load(*globalEvalEnv, imageName);
+    if (mode == InterpreterMode::FILEMODE)
+    {
+        // Each form is evaluated as soon as it has been read and then dropped, while later forms are
+        // parsed in the background.
+        try
+        {
+            while (auto value = fileReader->next())
+                globalEvalEnv->eval(std::move(value));
+        }
+        catch (ExitEvent& e)
+        {
+            exitCode = e.exitCode();
+        }
+        return exitCode;
+    }
     while (true)
     {
         try
         {
-            if (mode == InterpreterMode::REPLMODE)
-                cout << ">>> ";
-            bool isEOF = codeReader->tokenizeAndParseLine();
-            if (mode == InterpreterMode::REPLMODE)
+            auto& port = currentOutputPort();
+            port.write(codeReader->isInsideDatum() ? "... " : ">>> ");
+            port.flush();
+            bool isEOF = codeReader->readChunk();
+            auto values = evalAll();
+            for (auto value : values)
             {
-                auto values = evalAll();
-                for (auto value : values)
-                {
-                    cout << value->toString() << endl;
-                }
+                port.print(*value, false);
+                port.put('\n');
             }
             if(!isEOF)
                 break;
@@ -66,34 +110,21 @@ int Interpreter::run()
         }
         catch (SyntaxError& e)
         {
-            if (mode == InterpreterMode::REPLMODE)
-            {
-                cerr << "SyntaxError: " << e.what() << endl;
-                codeReader->cleanUpValueList();
-            }
-            else
-                throw;
+            currentOutputPort().flush();
+            cerr << "SyntaxError: " << e.what() << endl;
+            codeReader->discardPending();
         }
         catch (LispError& e)
         {
-            if (mode == InterpreterMode::REPLMODE)
-            {
-                std::cerr << "LispError: " << e.what() << std::endl;
-                codeReader->cleanUpValueList();
-            }
-            else
-                throw;
+            currentOutputPort().flush();
+            std::cerr << "LispError: " << e.what() << std::endl;
+            codeReader->discardPending();
         }
-    }
-    if (mode == InterpreterMode::FILEMODE)
-    {
-        try
+        catch (InterpreterError& e)
         {
-            evalAll();
-        }
-        catch (ExitEvent& e)
-        {
-            exitCode = e.exitCode();
+            currentOutputPort().flush();
+            std::cerr << "InterpreterError: " << e.what() << std::endl;
+            codeReader->discardPending();
         }
     }
     return exitCode;
@@ -12,13 +12,18 @@
 #include "./parser.h"
 #include "./eval_env.h"
 #include "./reader.h"
+#include "./fasl.h"
+#include "./image.h"
+#include "./port.h"
 
 using std::istream, std::cin, std::cout, std::cerr, std::endl, std::ifstream, std::string, std::streambuf, std::shared_ptr, std::make_shared, std::deque;
 
 enum InterpreterMode
 {
     FILEMODE,
-    REPLMODE
+    REPLMODE,
+    // Writes the FASL cache of a file instead of running it.
+    COMPILEMODE
 };
 
 class Interpreter
@@ -27,12 +32,17 @@ class Interpreter
     EnvPtr globalEvalEnv;
     int exitCode;
     shared_ptr<Reader> codeReader;
+    string fileName;
+    shared_ptr<FormReader> fileReader;
+    // Loaded into the global environment before anything runs, if set.
+    string imageName;
 private:
     InterpreterMode getMode() const;
     ValueList evalAll();
     Interpreter();
-    Interpreter(const string& fileName);
+    Interpreter(const string& fileName, InterpreterMode mode);
 public:
+    // Throws InterpreterError on a usage error or a file that cannot be opened.
     static shared_ptr<Interpreter> createInterpreter(int argc, const char** argv);
     int run();
     ~Interpreter();
@@ -11,18 +11,16 @@
 #define __ENABLE_TEST
 #endif // defined(DEBUG) || defined(_DEBUG)
 
-#define __DO_RJSJ_TEST
-
 #ifdef __ENABLE_TEST
 #include "./rjsj_test.hpp"
+#include "./my_test.hpp"
 
 struct TestCtx 
 {
     EnvPtr env = EvalEnv::createGlobal();
     std::string eval(std::string input) 
     {
-        auto tokens = Tokenizer::tokenize(input);
-        Parser parser(std::move(tokens));
+        Parser parser(input);
         auto value = parser.parse();
         auto result = env->eval(std::move(value));
         return result->toString();
@@ -32,28 +30,39 @@ struct TestCtx
 
 int main(int argc, const char ** argv) 
 {
-#ifdef __DO_RJSJ_TEST
-    RJSJ_TEST(TestCtx, Lv2, Lv3, Lv4, Lv5, Lv5Extra, Lv6, Lv7, Lv7Lib);
-#endif //__DO_RJSJ_TEST
+    // The test levels run only when asked for, and exit with their result.
+    if (argc == 2 && std::string(argv[1]) == "--selftest")
+    {
+#ifdef __ENABLE_TEST
+        RJSJ_TEST(TestCtx, Lv2, Lv3, Lv4, Lv5, Lv5Extra, Lv6, Lv7, Lv7Lib, MyTest);
+#else
+        std::cerr << "Self-tests are only built into debug builds." << std::endl;
+        return -3;
+#endif //__ENABLE_TEST
+    }
 
-    std::shared_ptr<Interpreter> interpreter = Interpreter::createInterpreter(argc, argv);
     int exitCode = 0;
     try
     {
+        // Inside the try, so a bad argument or an unreadable file is reported like any other error.
+        std::shared_ptr<Interpreter> interpreter = Interpreter::createInterpreter(argc, argv);
         exitCode = interpreter->run();
     }
     catch (SyntaxError& e)
     {
+        currentOutputPort().flush();
         std::cerr << "SyntaxError: " << e.what() << std::endl;
         exitCode = -1;
     }
     catch (LispError& e)
     {
+        currentOutputPort().flush();
         std::cerr << "LispError: " << e.what() << std::endl;
         exitCode = -2;
     }
     catch (InterpreterError& e)
     {
+        currentOutputPort().flush();
         std::cerr << "InterpreterError: " << e.what() << std::endl;
         exitCode = -3;
     }
@@ -0,0 +1,99 @@
+#include "./mapped_file.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& fileName)
+{
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+    LARGE_INTEGER fileSize{};
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return nullptr;
+    }
+    auto result = std::shared_ptr<MappedFile>(new MappedFile);
+    result->data = static_cast<const char*>(view);
+    result->size = static_cast<size_t>(fileSize.QuadPart);
+    result->fileHandle = file;
+    result->mappingHandle = mapping;
+    return result;
+}
+
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(data);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+}
+
+void MappedFile::release(size_t offset)
+{
+    // Clean file-backed pages are trimmed from the working set by the system as needed.
+}
+
+#else
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& fileName)
+{
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced on its own.
+    ::close(fd);
+    if (view == MAP_FAILED)
+        return nullptr;
+    madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    auto result = std::shared_ptr<MappedFile>(new MappedFile);
+    result->data = static_cast<const char*>(view);
+    result->size = static_cast<size_t>(info.st_size);
+    return result;
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(const_cast<char*>(data), size);
+}
+
+void MappedFile::release(size_t offset)
+{
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t end = std::min(offset, size) / pageSize * pageSize;
+    if (end <= released)
+        return;
+    madvise(const_cast<char*>(data) + released, end - released, MADV_DONTNEED);
+    released = end;
+}
+
+#endif
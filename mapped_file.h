@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+// A whole file mapped read-only into memory, so it can be tokenized in place without copying.
+class MappedFile
+{
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t released = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+    MappedFile() = default;
+public:
+    // Maps fileName, or returns nullptr if it cannot be mapped (missing, empty, or not a regular file
+    // such as a pipe); callers then fall back to stream reads.
+    static std::shared_ptr<MappedFile> open(const std::string& fileName);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    std::string_view view() const { return { data, size }; }
+    // Tells the system the bytes before offset will not be read again, so their pages can leave
+    // the working set instead of piling up as a large file is read.
+    void release(size_t offset);
+};
+
+#endif // !MAPPED_FILE_H
@@ -3,7 +3,294 @@
 
 #include "./rjsj_test.hpp"
 
+// rjsj_test.hpp undefines its case macros after the built-in levels, so redefine them here.
+#define RMLT_BEGIN_CASES(NAME)                                                  \
+    static const rjsj_mini_lisp_test::Cases RMLT_INTERNAL_CASE_PREFIXED(NAME) { \
+        #NAME, {
+#define RMLT_CASE(input, ...) {input, PP_IF(PP_IS_EMPTY(__VA_ARGS__), std::nullopt, __VA_ARGS__)},
+#define RMLT_END_CASES(...) \
+    }                       \
+    }                       \
+    ;
+
+// Source text of a quoted list holding count copies of element.
+inline std::string quotedList(size_t count, const std::string& element = "0")
+{
+    std::string result = "'(";
+    result.reserve(count * (element.size() + 1) + 3);
+    for (size_t i = 0; i < count; i++)
+        result.append(element).push_back(' ');
+    result.push_back(')');
+    return result;
+}
+
+// Source text of a quoted datum: element wrapped in depth lists.
+inline std::string quotedNesting(size_t depth, const std::string& element = "0")
+{
+    return "'" + std::string(depth, '(') + element + std::string(depth, ')');
+}
+
+// Source text of an expression that writes text to a new file called fileName.
+inline std::string writeFile(const std::string& fileName, const std::string& text)
+{
+    std::string literal;
+    literal.reserve(text.size() + 2);
+    for (char c : text)
+    {
+        if (c == '\\' || c == '"')
+            literal.push_back('\\');
+        if (c == '\n')
+            literal.append("\\n");
+        else
+            literal.push_back(c);
+    }
+    return "(let ((port (open-output-file \"" + fileName + "\"))) (write-string \"" + literal + "\" port) (close-port port))";
+}
+
+// A script for the FASL cache tests: improper lists, fixnums at the ends of their range, bignums,
+// flonums, strings, characters, vectors, and symbols that come back again and again.
+inline const std::string faslSource =
+    "(define fasl-data '((a b . c) -5 9223372036854775807 -9223372036854775808\n"
+    "  123456789012345678901234567890 -98765432109876543210987654321 2.5 -0.125 1e300\n"
+    "  \"s\\\"q\" #\\x #\\( #t #f () #(1 sym sym) sym (sym . sym) ((sym))))\n"
+    "(define fasl-syms (list 'sym 'a 'sym))\n";
+
+// A source, and the same source with bytes 31 and 39 changed: the top bytes of two adjacent 64-bit
+// words, an edit that a hash without feedback from high bits to low ones would miss.
+inline const std::string faslHashSource = "(define fasl-hash-data \"0000000000000000\")\n";
+inline const std::string faslHashEdited = "(define fasl-hash-data \"000000010000000m\")\n";
+
+// Appends comment lines, each holding a '(' that must not count, until text is size bytes long.
+inline void padTo(std::string& text, size_t size)
+{
+    while (text.size() < size)
+    {
+        size_t length = std::min<size_t>(size - text.size(), 64);
+        if (length < 4)
+            text.append(length, ' ');
+        else
+            text.append("; (").append(length - 4, '-').push_back('\n');
+    }
+}
+
+// A script for the reader tests. A file is read 64 KB at a time, so the string literal spans the
+// first block boundary and the ( of the #\( literal begins the third block.
+inline const std::string readerSource = [] {
+    std::string text = "(define reader-sum\n  (+ 1\n     2))\n; a comment holding ( and \"\n(define reader-comment 'after)\n";
+    padTo(text, (1 << 16) - 100);
+    text += "(define reader-string \"" + std::string(200, 'x') + "\")\n";
+    std::string charForm = "(define reader-char #\\(";
+    padTo(text, (2 << 16) - (charForm.size() - 1));
+    text += charForm + ")\n(define reader-last 'done)\n";
+    return text;
+}();
+
+// A script with a syntax error in its second block, after forms in both blocks.
+inline const std::string syntaxErrorSource = [] {
+    std::string text = "(define before-error-1 1)\n";
+    padTo(text, (1 << 16) + 1000);
+    return text + "(define before-error-2 2)\n(define bad-form (1 . ))\n(define after-error 3)\n";
+}();
+
 RMLT_BEGIN_CASES(MyTest)
+RMLT_CASE("(define v (make-f64vector 5 1.5))")
+RMLT_CASE("(f64vector-length v)", "5")
+RMLT_CASE("(f64vector-set! v 2 4)")
+RMLT_CASE("(f64vector-ref v 2)", "4")
+RMLT_CASE("(f64vector->list (f64vector-add v v))", "(3 3 8 3 3)")
+RMLT_CASE("(f64vector->list (f64vector-scale (list->f64vector '(1 2 3)) -2))", "(-2 -4 -6)")
+RMLT_CASE("(f64vector-dot (f64vector 1 2 3 4 5) (f64vector 5 4 3 2 1))", "35")
+RMLT_CASE("(f64vector-sum (vector->f64vector (vector 1 2 3 4 5 6 7 8 9)))", "45")
+RMLT_CASE("(f64vector-min (f64vector 3 -1 4 1 -5 9 2 6 5))", "-5")
+RMLT_CASE("(f64vector-max (f64vector 3 -1 4 1 -5 9 2 6 5))", "9")
+RMLT_CASE("(f64vector->list (f64vector-map 'sqrt (f64vector 1 4 9 16 25)))", "(1 2 3 4 5)")
+RMLT_CASE("(f64vector->list (f64vector-map abs (f64vector -1 2 -3)))", "(1 2 3)")
+RMLT_CASE("(f64vector->list (f64vector-map - (f64vector -1 2 -3)))", "(1 -2 3)")
+RMLT_CASE("(f64vector->list (f64vector-map (lambda (x) (* x 10)) (f64vector 1 2)))", "(10 20)")
+RMLT_CASE("(vector-ref (f64vector->vector (f64vector 7 8)) 1)", "8")
+RMLT_CASE("(define a (list->matrix '((1 2 3) (4 5 6))))")
+RMLT_CASE("(define b (list->matrix '((7 8) (9 10) (11 12))))")
+RMLT_CASE("(matrix->list (matrix-mul a b))", "((58 64) (139 154))")
+RMLT_CASE("(matrix->list (matrix-transpose a))", "((1 4) (2 5) (3 6))")
+RMLT_CASE("(matrix->list (matrix-add a a))", "((2 4 6) (8 10 12))")
+RMLT_CASE("(matrix-set! a 1 2 -6)")
+RMLT_CASE("(matrix-ref a 1 2)", "-6")
+RMLT_CASE("(f64vector->list (matrix-row a 1))", "(4 5 -6)")
+RMLT_CASE("(f64vector->list (matrix-column b 1))", "(8 10 12)")
+RMLT_CASE("(matrix-cols (make-matrix 2 7))", "7")
+RMLT_CASE("(define bv (make-bytevector 12 7))")
+RMLT_CASE("(bytevector-u8-ref bv 11)", "7")
+RMLT_CASE("(bytevector-u32-set! bv 0 305419896 'big)")
+RMLT_CASE("(bytevector-u8-ref bv 0)", "18")
+RMLT_CASE("(bytevector-u32-ref bv 0 'little)", "2018915346")
+RMLT_CASE("(bytevector-f64-set! bv 4 -2.5)")
+RMLT_CASE("(bytevector-f64-ref bv 4)", "-2.5")
+RMLT_CASE("(bytevector-copy! bv 1 (bytevector 1 2 3 4) 1 3)")
+RMLT_CASE("(list (bytevector-u8-ref bv 0) (bytevector-u8-ref bv 1) (bytevector-u8-ref bv 2) (bytevector-u8-ref bv 3))", "(18 2 3 120)")
+RMLT_CASE("(bytevector-fill! bv 255)")
+RMLT_CASE("(bytevector-length (bytevector-copy bv 2 5))", "3")
+RMLT_CASE("(= (* 99999999999 99999999999) 9999999999800000000001)", "#t")
+RMLT_CASE("(= (+ 9223372036854775807 1) 9223372036854775808)", "#t")
+RMLT_CASE("(- (+ 9223372036854775807 1) 1)", "9223372036854775807")
+RMLT_CASE("(= (expt 2 100) 1267650600228229401496703205376)", "#t")
+RMLT_CASE("(= (quotient (expt 10 30) 1000000000000000000001) 999999999)", "#t")
+RMLT_CASE("(remainder (+ (expt 2 100) 7) (expt 2 64))", "7")
+RMLT_CASE("(modulo (- (expt 3 50)) 7)", "5")
+RMLT_CASE("(= (gcd (expt 2 80) (expt 6 40)) (expt 2 40))", "#t")
+RMLT_CASE("(even? (expt 2 70))", "#t")
+RMLT_CASE("(/ 6 3)", "2")
+RMLT_CASE("(/ 1 4)", "0.25")
+RMLT_CASE("(number->string 255 16)", "\"ff\"")
+RMLT_CASE("(number->string (expt 2 64) 16)", "\"10000000000000000\"")
+RMLT_CASE("(number->string 0.1)", "\"0.1\"")
+RMLT_CASE("(eq? 2 2.0)", "#f")
+RMLT_CASE("(equal? (expt 2 70) (expt 2 70))", "#t")
+RMLT_CASE("(list #xff #b-101 #o17 #d10 1e3 .5 -2.5e-1 1.)", "(255 -5 15 10 1000 0.5 -0.25 1)")
+RMLT_CASE("(symbol? '->string)", "#t")
+RMLT_CASE("(symbol? '...)", "#t")
+RMLT_CASE("(symbol? '1+)", "#t")
+RMLT_CASE("(= #x10000000000000000 (expt 2 64))", "#t")
+RMLT_CASE("(list->string (list #\\( #\\a #\\)))", "\"(a)\"")
+RMLT_CASE("(string-length \"a\\\"b\\nc\")", "5")
+RMLT_CASE("(define big " + quotedList(10000000, "x") + ")")
+RMLT_CASE("(list (length big) (car big) (length (cdr big)))", "(10000000 x 9999999)")
+RMLT_CASE("(define big '())")
+RMLT_CASE("(vector-length (car " + quotedList(1000000, "#(1 (2 . 3))") + "))", "2")
+RMLT_CASE("(length " + quotedNesting(900, "1 2 3") + ")", "1")
+RMLT_CASE("(let loop ((x " + quotedNesting(900, "1 2 3") + ")) (if (pair? (car x)) (loop (car x)) x))", "(1 2 3)")
+RMLT_CASE("(define builtin-abs abs)")
+RMLT_CASE("(define (abs x) 'redefined)")
+RMLT_CASE("(let ((x -1)) ((lambda () (abs x))))", "redefined")
+RMLT_CASE("(set! abs builtin-abs)")
+RMLT_CASE("(abs -1)", "1")
+RMLT_CASE("(write-string \"\")", "()")
+RMLT_CASE("(flush-output)", "()")
+RMLT_CASE("(define cv (vector 1 2))")
+RMLT_CASE("(vector-set! cv 1 cv)")
+RMLT_CASE("cv", "#0=#(1 #0#)")
+RMLT_CASE("(vector cv cv)", "#(#0=#(1 #0#) #0#)")
+RMLT_CASE("(vector \"a\\\"b\" #\\c '(1 . 2))", "#(\"a\\\"b\" #\\c (1 . 2))")
+RMLT_CASE("(define sp (open-output-string))")
+RMLT_CASE("(write \"a\" sp)", "()")
+RMLT_CASE("(display \"b\" sp)", "()")
+RMLT_CASE("(newline sp)", "()")
+RMLT_CASE("(get-output-string sp)", "\"\\\"a\\\"b\n\"")
+RMLT_CASE("(with-output-to-string (lambda () (write-string \"x\") (write 'y)))", "\"xy\"")
+RMLT_CASE("(print-length 2)", "()")
+RMLT_CASE("(with-output-to-string (lambda () (write '(1 2 3))))", "\"(1 2 ...)\"")
+RMLT_CASE("(print-length #f)", "()")
+RMLT_CASE("(define sv (vector 1))")
+RMLT_CASE("(with-output-to-string (lambda () (write-shared (vector sv sv))))", "\"#(#0=#(1) #0#)\"")
+RMLT_CASE("(port? (current-output-port))", "#t")
+RMLT_CASE("(define op (open-output-file \"mini-lisp-port-test.txt\"))")
+RMLT_CASE("(write-string (string #\\a #\\b (integer->char 13)) op)", "()")
+RMLT_CASE("(write-string \"\\n(1 \\\"x\\\") c\\nlast\" op)", "()")
+RMLT_CASE("(close-port op)", "()")
+RMLT_CASE("(define ip (open-input-file \"mini-lisp-port-test.txt\"))")
+RMLT_CASE("(list (char->integer (peek-char ip)) (char->integer (read-char ip)) (read-line ip))", "(97 97 \"b\")")
+RMLT_CASE("(list (read ip) (read-line ip) (read-line ip))", "((1 \"x\") \" c\" \"last\")")
+RMLT_CASE("(list (eof-object? (read-line ip)) (eof-object? (read ip)) (input-port? ip) (output-port? ip))", "(#t #t #t #f)")
+RMLT_CASE("(close-port ip)", "()")
+RMLT_CASE("(call-with-input-file \"mini-lisp-port-test.txt\" read)", "ab")
+RMLT_CASE("(define lines '())")
+RMLT_CASE("(for-each-line \"mini-lisp-port-test.txt\" (lambda (l) (set! lines (cons l lines))))", "()")
+RMLT_CASE("lines", "(\"last\" \"(1 \\\"x\\\") c\" \"ab\")")
+RMLT_CASE("(define kept #f)")
+RMLT_CASE("(for-each-line \"mini-lisp-port-test.txt\" (lambda (l) (if (not kept) (set! kept l))))", "()")
+RMLT_CASE("kept", "\"ab\"")
+RMLT_CASE("(define records '())")
+RMLT_CASE("(for-each-record \"mini-lisp-port-test.txt\" #\\space (lambda (r) (set! records (cons r records))))", "()")
+RMLT_CASE("records", "((\"last\") (\"(1\" \"\\\"x\\\")\" \"c\") (\"ab\"))")
+RMLT_CASE("(delete-file \"mini-lisp-port-test.txt\")", "()")
+RMLT_CASE("(file-exists? \"mini-lisp-port-test.txt\")", "#f")
+RMLT_CASE("(string-split \"a,b,,c\" #\\,)", "(\"a\" \"b\" \"\" \"c\")")
+RMLT_CASE("(string-split \"a::b::\" \"::\")", "(\"a\" \"b\" \"\")")
+RMLT_CASE("(string-join '(\"a\" \"b\" \"c\") \", \")", "\"a, b, c\"")
+RMLT_CASE("(string-join '())", "\"\"")
+RMLT_CASE("(list (string-index \"hello\" #\\l) (string-index \"hello\" #\\l 3) (string-index \"hello\" #\\z))", "(2 3 #f)")
+RMLT_CASE("(string-contains \"the quick brown fox jumps over the lazy dog\" \"lazy\")", "35")
+RMLT_CASE("(list (string-search \"o\" \"foo\" 2) (string-search \"x\" \"foo\") (string-contains \"abc\" \"\"))", "(2 #f 0)")
+RMLT_CASE("(list (string-prefix? \"ab\" \"abc\") (string-suffix? \"bc\" \"abc\") (string-prefix? \"abcd\" \"abc\"))", "(#t #t #f)")
+RMLT_CASE("(list (string=? \"abc\" \"abc\") (string<? \"abc\" \"abd\") (string<? \"ab\" \"abc\") (string>? \"b\" \"abc\"))", "(#t #t #t #t)")
+RMLT_CASE("(list (string-ci=? \"Hello, World! 0123456789\" \"hELLO, wORLD! 0123456789\") (string-ci<? \"apple\" \"BANANA\") (string-ci<? \"Zebra\" \"apple\"))", "(#t #t #f)")
+RMLT_CASE("(list (string-ci=? \"[\" \"{\") (string-ci<? \"abcdefghijklmnopqrstuvwxyZ\" \"ABCDEFGHIJKLMNOPQRSTUVWXYZ!\") (string-ci>=? \"ABC\" \"abc\"))", "(#f #t #t)")
+RMLT_CASE("(list (char-ci=? #\\A #\\a) (char-ci<? #\\a #\\B))", "(#t #t)")
+RMLT_CASE("(sort '(\"pear\" \"Apple\" \"banana\" \"apple\") string-ci<?)", "(\"Apple\" \"apple\" \"banana\" \"pear\")")
+RMLT_CASE("(sort (vector 3 1 2) <)", "#(1 2 3)")
+RMLT_CASE(writeFile("mini-lisp-fasl-test.scm", faslSource), "()")
+RMLT_CASE("(load \"mini-lisp-fasl-test.scm\")", "()")
+RMLT_CASE("(define from-source (with-output-to-string (lambda () (write (list fasl-data fasl-syms)))))")
+RMLT_CASE("(compile-file \"mini-lisp-fasl-test.scm\")", "()")
+RMLT_CASE("(file-exists? \"mini-lisp-fasl-test.fasl\")", "#t")
+RMLT_CASE("(define fasl-data #f)")
+RMLT_CASE("(load \"mini-lisp-fasl-test.scm\")", "()")
+RMLT_CASE("(string=? (with-output-to-string (lambda () (write (list fasl-data fasl-syms)))) from-source)", "#t")
+RMLT_CASE("(list (car fasl-data) fasl-syms)", "((a b . c) (sym a sym))")
+RMLT_CASE(writeFile("mini-lisp-fasl-test.scm", "(define fasl-data 'edited)" + std::string(faslSource.size() - 26, ' ')), "()")
+RMLT_CASE("(with-output-to-string (lambda () (load \"mini-lisp-fasl-test.scm\")))", "\"\"")
+RMLT_CASE("(eq? fasl-data 'edited)", "#t")
+RMLT_CASE("(compile-file \"mini-lisp-fasl-test.scm\")", "()")
+RMLT_CASE("(let ((b (read-bytevector \"mini-lisp-fasl-test.fasl\"))) (write-bytevector (bytevector-copy b 0 (- (bytevector-length b) 4)) \"mini-lisp-fasl-test.fasl\"))", "()")
+RMLT_CASE("(define fasl-data #f)")
+RMLT_CASE("(with-output-to-string (lambda () (load \"mini-lisp-fasl-test.scm\")))", "\"\"")
+RMLT_CASE("(eq? fasl-data 'edited)", "#t")
+RMLT_CASE(writeFile("mini-lisp-fasl-test.scm", faslHashSource), "()")
+RMLT_CASE("(compile-file \"mini-lisp-fasl-test.scm\")", "()")
+RMLT_CASE(writeFile("mini-lisp-fasl-test.scm", faslHashEdited), "()")
+RMLT_CASE("(load \"mini-lisp-fasl-test.scm\")", "()")
+RMLT_CASE("(string=? fasl-hash-data \"000000010000000m\")", "#t")
+RMLT_CASE("(delete-file \"mini-lisp-fasl-test.scm\")", "()")
+RMLT_CASE("(delete-file \"mini-lisp-fasl-test.fasl\")", "()")
+RMLT_CASE("(guard (e ((error-object? e) (error-object-message e))) (vector-ref (vector) 0) 'unreached)", "\"Index 0 out of range\"")
+RMLT_CASE("(guard (outer (#t 'outer)) (guard (inner ((read-error? inner) 'inner)) (car '())))", "outer")
+RMLT_CASE(writeFile("mini-lisp-reader-test.scm", readerSource), "()")
+RMLT_CASE("(load \"mini-lisp-reader-test.scm\")", "()")
+RMLT_CASE("(list reader-sum reader-comment (string-length reader-string) (char->integer reader-char) reader-last)", "(3 after 200 40 done)")
+RMLT_CASE(writeFile("mini-lisp-reader-test.scm", syntaxErrorSource), "()")
+RMLT_CASE("(guard (e ((read-error? e) 'syntax-error)) (load \"mini-lisp-reader-test.scm\"))", "syntax-error")
+RMLT_CASE("(list before-error-1 before-error-2)", "(1 2)")
+RMLT_CASE("(guard (e ((error-object? e) 'undefined)) after-error)", "undefined")
+RMLT_CASE("(delete-file \"mini-lisp-reader-test.scm\")", "()")
+RMLT_CASE("(define image-c1 #f)")
+RMLT_CASE("(define image-c2 #f)")
+RMLT_CASE("(let ((n 0)) (set! image-c1 (lambda () (set! n (+ n 1)) n)) (set! image-c2 (lambda () n)))", "()")
+RMLT_CASE("(image-c1)", "1")
+RMLT_CASE("(define image-cycle (vector 1 2))")
+RMLT_CASE("(vector-set! image-cycle 1 image-cycle)", "()")
+RMLT_CASE("(define image-forced (delay (+ 1 2)))")
+RMLT_CASE("(force image-forced)", "3")
+RMLT_CASE("(define image-runs 0)")
+RMLT_CASE("(define image-lazy (delay (begin (set! image-runs (+ image-runs 1)) image-runs)))")
+RMLT_CASE("(define image-abs abs)")
+RMLT_CASE("(define (abs x) 'redefined)")
+RMLT_CASE("(guard (e ((error-object? e) 'unsaveable)) (save-image \"mini-lisp-image-test.img\"))", "unsaveable")
+RMLT_CASE("(define sp #f)")
+RMLT_CASE("(define op #f)")
+RMLT_CASE("(define ip #f)")
+RMLT_CASE("(save-image \"mini-lisp-image-test.img\")", "()")
+RMLT_CASE("(define image-c1 #f)")
+RMLT_CASE("(define image-c2 #f)")
+RMLT_CASE("(define image-cycle #f)")
+RMLT_CASE("(define image-forced #f)")
+RMLT_CASE("(define image-lazy #f)")
+RMLT_CASE("(define abs image-abs)")
+RMLT_CASE("(load-image \"mini-lisp-image-test.img\")", "()")
+RMLT_CASE("(list (image-c1) (image-c1) (image-c2))", "(2 3 3)")
+RMLT_CASE("(eq? (vector-ref image-cycle 1) image-cycle)", "#t")
+RMLT_CASE("(list (force image-forced) image-runs (force image-lazy) (force image-lazy) image-runs)", "(3 0 1 1 1)")
+RMLT_CASE("(abs -5)", "redefined")
+RMLT_CASE("(define abs image-abs)")
+RMLT_CASE("(define image-c1 'kept)")
+RMLT_CASE("(let ((b (read-bytevector \"mini-lisp-image-test.img\"))) (bytevector-u8-set! b 31 (- 255 (bytevector-u8-ref b 31))) (bytevector-u8-set! b 39 (- 255 (bytevector-u8-ref b 39))) (write-bytevector b \"mini-lisp-image-test.img\"))", "()")
+RMLT_CASE("(guard (e ((error-object? e) (error-object-message e))) (load-image \"mini-lisp-image-test.img\"))", "\"Corrupt image file\"")
+RMLT_CASE("(let ((b (read-bytevector \"mini-lisp-image-test.img\"))) (write-bytevector (bytevector-copy b 0 (- (bytevector-length b) 4)) \"mini-lisp-image-test.img\"))", "()")
+RMLT_CASE("(guard (e ((error-object? e) (error-object-message e))) (load-image \"mini-lisp-image-test.img\"))", "\"Corrupt image file\"")
+RMLT_CASE("(list image-c1 (abs -5))", "(kept 5)")
+RMLT_CASE("(delete-file \"mini-lisp-image-test.img\")", "()")
 RMLT_END_CASES()
 
+#undef RMLT_BEGIN_CASES
+#undef RMLT_CASE
+#undef RMLT_END_CASES
+
 #endif // !MY_TEST
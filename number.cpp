@@ -0,0 +1,402 @@
+#include "./number.h"
+
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    bool addOverflow(long long lhs, long long rhs, long long& result)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_add_overflow(lhs, rhs, &result);
+#else
+        if ((rhs > 0 && lhs > LLONG_MAX - rhs) || (rhs < 0 && lhs < LLONG_MIN - rhs))
+            return true;
+        result = lhs + rhs;
+        return false;
+#endif
+    }
+
+    bool subOverflow(long long lhs, long long rhs, long long& result)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_sub_overflow(lhs, rhs, &result);
+#else
+        if ((rhs < 0 && lhs > LLONG_MAX + rhs) || (rhs > 0 && lhs < LLONG_MIN + rhs))
+            return true;
+        result = lhs - rhs;
+        return false;
+#endif
+    }
+
+    bool mulOverflow(long long lhs, long long rhs, long long& result)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_mul_overflow(lhs, rhs, &result);
+#else
+        if (lhs > 0 ? (rhs > 0 ? lhs > LLONG_MAX / rhs : rhs < LLONG_MIN / lhs)
+                    : (rhs > 0 ? lhs < LLONG_MIN / rhs : (lhs != 0 && rhs < LLONG_MAX / lhs)))
+            return true;
+        result = lhs * rhs;
+        return false;
+#endif
+    }
+}
+
+Number::Number(BigInt value)
+{
+    if (value.fitsInt64())
+        repr = value.toInt64();
+    else
+        repr = std::make_shared<const BigInt>(std::move(value));
+}
+
+const BigInt& Number::bignum() const
+{
+    return *std::get<std::shared_ptr<const BigInt>>(repr);
+}
+
+BigInt Number::toBigInt() const
+{
+    if (auto fixnum = std::get_if<long long>(&repr))
+        return BigInt(*fixnum);
+    return bignum();
+}
+
+namespace
+{
+    enum class LiteralKind
+    {
+        Invalid,
+        Exact,
+        Inexact
+    };
+
+    // Splits off a #x/#b/#o/#d prefix and an explicit '+' (which std::from_chars rejects).
+    std::string_view literalBody(std::string_view text, int& radix)
+    {
+        if (text.size() >= 2 && text[0] == '#')
+        {
+            switch (text[1])
+            {
+            case 'x': case 'X': radix = 16; break;
+            case 'b': case 'B': radix = 2; break;
+            case 'o': case 'O': radix = 8; break;
+            case 'd': case 'D': radix = 10; break;
+            default: return {};
+            }
+            text.remove_prefix(2);
+        }
+        if (!text.empty() && text[0] == '+')
+            text.remove_prefix(1);
+        return text;
+    }
+
+    LiteralKind scanLiteral(std::string_view body, int radix)
+    {
+        size_t pos = (!body.empty() && body[0] == '-') ? 1 : 0;
+        auto isDigit = [radix](char c) {
+            int value = (c >= '0' && c <= '9') ? c - '0'
+                : (c >= 'a' && c <= 'z') ? c - 'a' + 10
+                : (c >= 'A' && c <= 'Z') ? c - 'A' + 10 : 36;
+            return value < radix;
+        };
+        auto skipDigits = [&] {
+            size_t start = pos;
+            while (pos < body.size() && isDigit(body[pos]))
+                pos++;
+            return pos - start;
+        };
+
+        size_t mantissaDigits = skipDigits();
+        LiteralKind kind = LiteralKind::Exact;
+        if (radix == 10 && pos < body.size() && body[pos] == '.')
+        {
+            pos++;
+            mantissaDigits += skipDigits();
+            kind = LiteralKind::Inexact;
+        }
+        if (mantissaDigits == 0)
+            return LiteralKind::Invalid;
+        if (radix == 10 && pos < body.size() && (body[pos] == 'e' || body[pos] == 'E'))
+        {
+            pos++;
+            if (pos < body.size() && (body[pos] == '+' || body[pos] == '-'))
+                pos++;
+            if (skipDigits() == 0)
+                return LiteralKind::Invalid;
+            kind = LiteralKind::Inexact;
+        }
+        return pos == body.size() ? kind : LiteralKind::Invalid;
+    }
+}
+
+bool Number::isLiteral(std::string_view text, int radix)
+{
+    std::string_view body = literalBody(text, radix);
+    return scanLiteral(body, radix) != LiteralKind::Invalid;
+}
+
+std::optional<Number> Number::fromString(std::string_view text, int radix)
+{
+    std::string_view body = literalBody(text, radix);
+    LiteralKind kind = scanLiteral(body, radix);
+    if (kind == LiteralKind::Invalid)
+        return std::nullopt;
+
+    const char* first = body.data();
+    const char* last = body.data() + body.size();
+    if (kind == LiteralKind::Exact)
+    {
+        long long fixnum;
+        auto [ptr, ec] = std::from_chars(first, last, fixnum, radix);
+        if (ec == std::errc{} && ptr == last)
+            return Number(fixnum);
+        auto value = BigInt::fromString(body, radix);
+        if (!value)
+            return std::nullopt;
+        return Number(std::move(*value));
+    }
+    double flonum;
+    auto [ptr, ec] = std::from_chars(first, last, flonum);
+    if (ec == std::errc::result_out_of_range)
+        return Number(std::strtod(std::string(body).c_str(), nullptr));
+    if (ec != std::errc{} || ptr != last)
+        return std::nullopt;
+    return Number(flonum);
+}
+
+bool Number::isExact() const
+{
+    return !std::holds_alternative<double>(repr);
+}
+
+bool Number::isFixnum() const
+{
+    return std::holds_alternative<long long>(repr);
+}
+
+long long Number::fixnum() const
+{
+    return std::get<long long>(repr);
+}
+
+bool Number::isInteger() const
+{
+    if (auto flonum = std::get_if<double>(&repr))
+        return std::isfinite(*flonum) && std::trunc(*flonum) == *flonum;
+    return true;
+}
+
+bool Number::isZero() const
+{
+    if (auto fixnum = std::get_if<long long>(&repr))
+        return *fixnum == 0;
+    if (auto flonum = std::get_if<double>(&repr))
+        return *flonum == 0;
+    return false;
+}
+
+bool Number::isNegative() const
+{
+    if (auto fixnum = std::get_if<long long>(&repr))
+        return *fixnum < 0;
+    if (auto flonum = std::get_if<double>(&repr))
+        return *flonum < 0;
+    return bignum().isNegative();
+}
+
+bool Number::isOdd() const
+{
+    if (auto fixnum = std::get_if<long long>(&repr))
+        return *fixnum & 1;
+    if (auto flonum = std::get_if<double>(&repr))
+        return std::fmod(*flonum, 2) != 0;
+    return bignum().isOdd();
+}
+
+double Number::toDouble() const
+{
+    if (auto fixnum = std::get_if<long long>(&repr))
+        return static_cast<double>(*fixnum);
+    if (auto flonum = std::get_if<double>(&repr))
+        return *flonum;
+    return bignum().toDouble();
+}
+
+void Number::appendTo(std::string& out, int radix) const
+{
+    // Large enough for any int64 in base 2 and any shortest-roundtrip double.
+    char buffer[72];
+    std::to_chars_result result;
+    if (auto fixnum = std::get_if<long long>(&repr))
+        result = std::to_chars(buffer, buffer + sizeof(buffer), *fixnum, radix);
+    else if (auto flonum = std::get_if<double>(&repr))
+    {
+        if (isInteger() && std::abs(*flonum) < 0x1p63)
+            result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<long long>(*flonum));
+        else
+            result = std::to_chars(buffer, buffer + sizeof(buffer), *flonum);
+    }
+    else
+    {
+        out += bignum().toString(radix);
+        return;
+    }
+    out.append(buffer, result.ptr);
+}
+
+std::string Number::toString(int radix) const
+{
+    std::string result;
+    appendTo(result, radix);
+    return result;
+}
+
+Number Number::operator-() const
+{
+    return Number(0LL) - *this;
+}
+
+Number operator+(const Number& lhs, const Number& rhs)
+{
+    if (!lhs.isExact() || !rhs.isExact())
+        return lhs.toDouble() + rhs.toDouble();
+    long long result;
+    if (lhs.isFixnum() && rhs.isFixnum() && !addOverflow(std::get<long long>(lhs.repr), std::get<long long>(rhs.repr), result))
+        return result;
+    return lhs.toBigInt() + rhs.toBigInt();
+}
+
+Number operator-(const Number& lhs, const Number& rhs)
+{
+    if (!lhs.isExact() || !rhs.isExact())
+        return lhs.toDouble() - rhs.toDouble();
+    long long result;
+    if (lhs.isFixnum() && rhs.isFixnum() && !subOverflow(std::get<long long>(lhs.repr), std::get<long long>(rhs.repr), result))
+        return result;
+    return lhs.toBigInt() - rhs.toBigInt();
+}
+
+Number operator*(const Number& lhs, const Number& rhs)
+{
+    if (!lhs.isExact() || !rhs.isExact())
+        return lhs.toDouble() * rhs.toDouble();
+    long long result;
+    if (lhs.isFixnum() && rhs.isFixnum() && !mulOverflow(std::get<long long>(lhs.repr), std::get<long long>(rhs.repr), result))
+        return result;
+    return lhs.toBigInt() * rhs.toBigInt();
+}
+
+Number Number::divide(const Number& lhs, const Number& rhs)
+{
+    if (lhs.isExact() && rhs.isExact() && remainder(lhs, rhs).isZero())
+        return quotient(lhs, rhs);
+    return lhs.toDouble() / rhs.toDouble();
+}
+
+Number Number::quotient(const Number& lhs, const Number& rhs)
+{
+    if (!lhs.isExact() || !rhs.isExact())
+        return std::trunc(lhs.toDouble() / rhs.toDouble());
+    if (lhs.isFixnum() && rhs.isFixnum())
+    {
+        long long x = std::get<long long>(lhs.repr), y = std::get<long long>(rhs.repr);
+        // LLONG_MIN / -1 is the only fixnum quotient that overflows.
+        if (!(x == LLONG_MIN && y == -1))
+            return x / y;
+    }
+    return BigInt::divMod(lhs.toBigInt(), rhs.toBigInt()).first;
+}
+
+Number Number::remainder(const Number& lhs, const Number& rhs)
+{
+    if (!lhs.isExact() || !rhs.isExact())
+        return std::fmod(lhs.toDouble(), rhs.toDouble());
+    if (lhs.isFixnum() && rhs.isFixnum())
+    {
+        long long x = std::get<long long>(lhs.repr), y = std::get<long long>(rhs.repr);
+        return y == -1 ? 0 : x % y;
+    }
+    return BigInt::divMod(lhs.toBigInt(), rhs.toBigInt()).second;
+}
+
+Number Number::modulo(const Number& lhs, const Number& rhs)
+{
+    Number result = remainder(lhs, rhs);
+    if (!result.isZero() && result.isNegative() != rhs.isNegative())
+        result = result + rhs;
+    return result;
+}
+
+Number Number::gcd(const Number& lhs, const Number& rhs)
+{
+    if (!lhs.isExact() || !rhs.isExact())
+    {
+        double x = std::abs(lhs.toDouble()), y = std::abs(rhs.toDouble());
+        while (y != 0)
+            x = std::fmod(x, y), std::swap(x, y);
+        return x;
+    }
+    if (lhs.isFixnum() && rhs.isFixnum())
+    {
+        // Magnitudes as unsigned so that |LLONG_MIN| is representable.
+        long long sx = std::get<long long>(lhs.repr), sy = std::get<long long>(rhs.repr);
+        unsigned long long x = sx < 0 ? 0 - static_cast<unsigned long long>(sx) : sx;
+        unsigned long long y = sy < 0 ? 0 - static_cast<unsigned long long>(sy) : sy;
+        while (y != 0)
+            x %= y, std::swap(x, y);
+        if (x <= static_cast<unsigned long long>(LLONG_MAX))
+            return static_cast<long long>(x);
+    }
+    BigInt x = lhs.toBigInt().abs(), y = rhs.toBigInt().abs();
+    while (!y.isZero())
+    {
+        x = BigInt::divMod(x, y).second;
+        std::swap(x, y);
+    }
+    return x;
+}
+
+Number Number::lcm(const Number& lhs, const Number& rhs)
+{
+    if (lhs.isZero() || rhs.isZero())
+        return lhs.isExact() && rhs.isExact() ? Number(0LL) : Number(0.0);
+    return abs(quotient(lhs, gcd(lhs, rhs)) * rhs);
+}
+
+Number Number::expt(const Number& base, const Number& exponent)
+{
+    Number result = 1LL, square = base;
+    BigInt remaining = exponent.toBigInt();
+    while (!remaining.isZero())
+    {
+        auto [half, bit] = BigInt::divMod(remaining, 2LL);
+        if (!bit.isZero())
+            result = result * square;
+        remaining = std::move(half);
+        if (!remaining.isZero())
+            square = square * square;
+    }
+    return result;
+}
+
+Number Number::abs(const Number& value)
+{
+    return value.isNegative() ? -value : value;
+}
+
+int Number::compare(const Number& lhs, const Number& rhs)
+{
+    if (lhs.isFixnum() && rhs.isFixnum())
+    {
+        long long x = std::get<long long>(lhs.repr), y = std::get<long long>(rhs.repr);
+        return (x > y) - (x < y);
+    }
+    if (lhs.isExact() && rhs.isExact())
+        return BigInt::compare(lhs.toBigInt(), rhs.toBigInt());
+    double x = lhs.toDouble(), y = rhs.toDouble();
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,78 @@
+#ifndef NUMBER_H
+#define NUMBER_H
+
+#include <concepts>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "./bigint.h"
+
+// A Scheme number: an exact fixnum (int64), an exact bignum, or an inexact flonum (double).
+// Exact arithmetic stays on the fixnum fast path and promotes to a bignum only on overflow;
+// bignum results that fit back into an int64 are demoted again.
+class Number
+{
+    std::variant<long long, double, std::shared_ptr<const BigInt>> repr;
+
+    const BigInt& bignum() const;
+    BigInt toBigInt() const;
+public:
+    Number()
+        :repr{ 0LL } {}
+    template<std::integral T>
+    Number(T value)
+        :repr{ static_cast<long long>(value) } {}
+    Number(double value)
+        :repr{ value } {}
+    Number(BigInt value);
+
+    // Parses a numeric literal with an optional #x/#b/#o/#d prefix: [+-]?digits is exact, and in radix 10
+    // a decimal point or exponent makes it inexact. Returns nullopt if text is not a number.
+    static std::optional<Number> fromString(std::string_view text, int radix = 10);
+    // Checks the literal grammar of fromString without converting.
+    static bool isLiteral(std::string_view text, int radix = 10);
+
+    bool isExact() const;
+    bool isFixnum() const;
+    bool isInteger() const;
+    bool isZero() const;
+    bool isNegative() const;
+    // Only meaningful when isInteger().
+    bool isOdd() const;
+    // Only meaningful when isFixnum().
+    long long fixnum() const;
+    double toDouble() const;
+    // Appends the textual form to out. Flonums use the shortest representation that reads back
+    // to the same double; integral flonums print without a fractional part. Radix applies to exact numbers only.
+    void appendTo(std::string& out, int radix = 10) const;
+    std::string toString(int radix = 10) const;
+
+    Number operator-() const;
+    friend Number operator+(const Number& lhs, const Number& rhs);
+    friend Number operator-(const Number& lhs, const Number& rhs);
+    friend Number operator*(const Number& lhs, const Number& rhs);
+
+    // Exact when lhs is divisible by rhs, inexact otherwise. rhs must be non-zero.
+    static Number divide(const Number& lhs, const Number& rhs);
+    // Integer division family; rhs must be non-zero and both operands integers.
+    static Number quotient(const Number& lhs, const Number& rhs);
+    static Number remainder(const Number& lhs, const Number& rhs);
+    static Number modulo(const Number& lhs, const Number& rhs);
+    static Number gcd(const Number& lhs, const Number& rhs);
+    static Number lcm(const Number& lhs, const Number& rhs);
+    // Exact base raised to a non-negative exact integer power, by repeated squaring.
+    static Number expt(const Number& base, const Number& exponent);
+    static Number abs(const Number& value);
+
+    static int compare(const Number& lhs, const Number& rhs);
+    friend bool operator==(const Number& lhs, const Number& rhs) { return compare(lhs, rhs) == 0; }
+    friend bool operator<(const Number& lhs, const Number& rhs) { return compare(lhs, rhs) < 0; }
+    friend bool operator>(const Number& lhs, const Number& rhs) { return compare(lhs, rhs) > 0; }
+    friend bool operator<=(const Number& lhs, const Number& rhs) { return compare(lhs, rhs) <= 0; }
+    friend bool operator>=(const Number& lhs, const Number& rhs) { return compare(lhs, rhs) >= 0; }
+};
+
+#endif // !NUMBER_H
@@ -0,0 +1,288 @@
+#include "./port.h"
+
+#include <cstring>
+#include <utility>
+
+#include "./reader.h"
+
+namespace
+{
+    std::FILE* openFile(const string& fileName, const char* mode)
+    {
+#ifdef _WIN32
+        std::FILE* file = nullptr;
+        return fopen_s(&file, fileName.c_str(), mode) == 0 ? file : nullptr;
+#else
+        return std::fopen(fileName.c_str(), mode);
+#endif
+    }
+}
+
+OutputPort::OutputPort()
+    :stream{ nullptr }, limit{ SIZE_MAX } {}
+
+OutputPort::OutputPort(std::FILE* stream)
+    :stream{ stream }, limit{ BufferSize }
+{
+    buffer.reserve(BufferSize);
+}
+
+OutputPort::~OutputPort()
+{
+    close();
+}
+
+shared_ptr<OutputPort> OutputPort::open(const string& fileName)
+{
+    std::FILE* file = openFile(fileName, "wb");
+    if (!file)
+        throw LispError("Open file \"" + fileName + "\" failed");
+    auto port = make_shared<OutputPort>(file);
+    port->ownsStream = true;
+    return port;
+}
+
+void OutputPort::print(const Value& value, bool isDisplay, bool labelShared)
+{
+    static Printer printer;
+    printer.print(buffer, value, { isDisplay, labelShared, printLength, printDepth });
+    if (buffer.size() >= limit)
+        flush();
+}
+
+void OutputPort::flush()
+{
+    if (isString() || isClosed)
+        return;
+    if (!buffer.empty())
+        std::fwrite(buffer.data(), 1, buffer.size(), stream);
+    buffer.clear();
+    std::fflush(stream);
+}
+
+void OutputPort::close()
+{
+    if (isClosed)
+        return;
+    flush();
+    if (ownsStream)
+        std::fclose(stream);
+    isClosed = true;
+}
+
+InputPort::InputPort(std::FILE* stream)
+    :stream{ stream }, isInteractive{ stream == stdin } {}
+
+InputPort::~InputPort()
+{
+    close();
+}
+
+shared_ptr<InputPort> InputPort::open(const string& fileName)
+{
+    std::FILE* file = openFile(fileName, "rb");
+    if (!file)
+        throw LispError("Open file \"" + fileName + "\" failed");
+    auto port = make_shared<InputPort>(file);
+    port->ownsStream = true;
+    return port;
+}
+
+bool InputPort::fill()
+{
+    if (isEnd || isClosed)
+        return false;
+    buffer.erase(0, pos);
+    pos = 0;
+    size_t start = buffer.size();
+    buffer.resize(start + BufferSize);
+    size_t count = 0;
+    if (isInteractive)
+    {
+        // A prompt written before the read has to be on screen while the user types.
+        currentOutputPort().flush();
+        if (std::fgets(buffer.data() + start, BufferSize, stream))
+            count = std::strlen(buffer.data() + start);
+    }
+    else
+    {
+        count = std::fread(buffer.data() + start, 1, BufferSize, stream);
+    }
+    buffer.resize(start + count);
+    isEnd = count == 0;
+    return !isEnd;
+}
+
+std::optional<std::string_view> InputPort::readLine()
+{
+    // The part of the unread input already searched for a newline, which filling does not change.
+    size_t searched = 0;
+    while (true)
+    {
+        const char* start = buffer.data() + pos;
+        auto newline = static_cast<const char*>(std::memchr(start + searched, '\n', buffer.size() - pos - searched));
+        if (newline)
+        {
+            std::string_view line(start, newline - start);
+            pos += line.size() + 1;
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            return line;
+        }
+        searched = buffer.size() - pos;
+        if (!fill())
+            break;
+    }
+    if (pos == buffer.size())
+        return std::nullopt;
+    // The last line has no line ending.
+    std::string_view line(buffer.data() + pos, buffer.size() - pos);
+    pos = buffer.size();
+    return line;
+}
+
+std::optional<char> InputPort::readChar()
+{
+    if (pos == buffer.size() && !fill())
+        return std::nullopt;
+    return buffer[pos++];
+}
+
+std::optional<char> InputPort::peekChar()
+{
+    if (pos == buffer.size() && !fill())
+        return std::nullopt;
+    return buffer[pos];
+}
+
+ValuePtr InputPort::read()
+{
+    DatumScanner scanner;
+    size_t scanned = 0;
+    while (true)
+    {
+        size_t end = scanner.scanFirst(std::string_view(buffer).substr(pos), scanned);
+        if (end != SIZE_MAX)
+        {
+            Parser parser(std::string_view(buffer).substr(pos, end));
+            auto value = parser.parse();
+            pos += end;
+            return value;
+        }
+        scanned = buffer.size() - pos;
+        if (!fill())
+            break;
+    }
+    // At the end of the input a datum needs nothing after it; an unfinished one is left to the parser
+    // to report.
+    Parser parser(std::string_view(buffer).substr(pos));
+    pos = buffer.size();
+    if (parser.isEmpty())
+        return nullptr;
+    return parser.parse();
+}
+
+void InputPort::close()
+{
+    if (isClosed)
+        return;
+    if (ownsStream)
+        std::fclose(stream);
+    buffer.clear();
+    pos = 0;
+    isClosed = true;
+}
+
+LineSource::LineSource(const string& fileName)
+    :mappedFile{ MappedFile::open(fileName) }
+{
+    if (mappedFile)
+        mappedText = mappedFile->view();
+    else
+        port = InputPort::open(fileName);
+}
+
+std::optional<std::string_view> LineSource::next()
+{
+    if (port)
+        return port->readLine();
+    if (pos == mappedText.size())
+        return std::nullopt;
+    if (pos - released >= ReleaseStep)
+    {
+        mappedFile->release(pos);
+        released = pos;
+    }
+    const char* start = mappedText.data() + pos;
+    auto newline = static_cast<const char*>(std::memchr(start, '\n', mappedText.size() - pos));
+    std::string_view line(start, newline ? newline - start : mappedText.size() - pos);
+    pos += line.size() + (newline ? 1 : 0);
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    return line;
+}
+
+string PortValue::toString() const
+{
+    if (inputPort)
+        return "#<input-port>";
+    return outputPort->isString() ? "#<string-output-port>" : "#<output-port>";
+}
+
+int PortValue::getTypeID() const
+{
+    return ValueType::PortType;
+}
+
+OutputPort* PortValue::output() const
+{
+    return outputPort.get();
+}
+
+InputPort* PortValue::input() const
+{
+    return inputPort.get();
+}
+
+ValuePtr PortValue::copy() const
+{
+    if (inputPort)
+        return make_shared<PortValue>(inputPort);
+    return make_shared<PortValue>(outputPort);
+}
+
+namespace
+{
+    shared_ptr<OutputPort>& currentPort()
+    {
+        // The standard port is not owned by the pointer, so it lives, and is flushed, until exit
+        // however many values still refer to it.
+        static OutputPort standardOutput{ stdout };
+        static shared_ptr<OutputPort> current(shared_ptr<OutputPort>(), &standardOutput);
+        return current;
+    }
+}
+
+OutputPort& currentOutputPort()
+{
+    return *currentPort();
+}
+
+shared_ptr<OutputPort> currentOutputPortPtr()
+{
+    return currentPort();
+}
+
+OutputRedirection::OutputRedirection(shared_ptr<OutputPort> port)
+    :previous{ std::exchange(currentPort(), std::move(port)) } {}
+
+OutputRedirection::~OutputRedirection()
+{
+    currentPort() = std::move(previous);
+}
+
+shared_ptr<InputPort> currentInputPortPtr()
+{
+    static auto standardInput = make_shared<InputPort>(stdin);
+    return standardInput;
+}
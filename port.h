@@ -0,0 +1,175 @@
+#ifndef PORT_H
+#define PORT_H
+
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "./mapped_file.h"
+#include "./printer.h"
+
+// Where display, write and newline send their text. Output collects in a userspace buffer and is
+// handed to the stream only when the buffer fills or on flush(), so printing a value costs a copy
+// into the buffer rather than a system call. A port without a stream is a string port: its buffer
+// just grows (amortized, like any std::string) and holds everything written to it.
+class OutputPort
+{
+    std::FILE* stream;
+    std::string buffer;
+    // The buffer is handed to the stream when it would grow past this.
+    size_t limit;
+    // Whether the stream was opened for the port, and is closed with it.
+    bool ownsStream = false;
+    bool isClosed = false;
+public:
+    static constexpr size_t BufferSize = 1 << 16;
+    // Limits on the values printed to any port, set by (print-length n) and (print-depth n). toString
+    // ignores them, so error messages still show whole values.
+    static inline size_t printLength = SIZE_MAX;
+    static inline size_t printDepth = SIZE_MAX;
+
+    // A string port.
+    OutputPort();
+    explicit OutputPort(std::FILE* stream);
+    OutputPort(const OutputPort&) = delete;
+    OutputPort& operator=(const OutputPort&) = delete;
+    ~OutputPort();
+    // A port writing to a new file called fileName, replacing any there was.
+    static shared_ptr<OutputPort> open(const string& fileName);
+
+    void write(std::string_view text)
+    {
+        if (buffer.size() + text.size() > limit)
+        {
+            flush();
+            if (text.size() >= limit)
+            {
+                std::fwrite(text.data(), 1, text.size(), stream);
+                return;
+            }
+        }
+        buffer += text;
+    }
+    void put(char c)
+    {
+        if (buffer.size() == limit)
+            flush();
+        buffer += c;
+    }
+    // Prints value straight into the buffer, in the display form or the write form.
+    void print(const Value& value, bool isDisplay, bool labelShared = false);
+    void flush();
+    // Flushes the port and lets its file go; it cannot be written to afterwards.
+    void close();
+
+    bool isString() const { return !stream; }
+    bool isOpen() const { return !isClosed; }
+    // Everything written to a string port so far.
+    const std::string& text() const { return buffer; }
+};
+
+// Where read-line, read-char, peek-char and read take their input from. The stream is read a block
+// at a time into a buffer, and lines and data are cut straight out of that, so reading a line costs a
+// search for its end and one copy into the string returned.
+class InputPort
+{
+    std::FILE* stream;
+    // The unread input is buffer[pos, buffer.size()).
+    std::string buffer;
+    size_t pos = 0;
+    bool isEnd = false;
+    // Whether the stream is the standard input, which is read a line at a time so that an
+    // interactive user is not kept waiting for a whole block.
+    bool isInteractive;
+    bool ownsStream = false;
+    bool isClosed = false;
+
+    // Reads more input onto the end of the buffer, dropping the part already read. Returns false at
+    // the end of the input.
+    bool fill();
+public:
+    static constexpr size_t BufferSize = 1 << 16;
+
+    explicit InputPort(std::FILE* stream);
+    InputPort(const InputPort&) = delete;
+    InputPort& operator=(const InputPort&) = delete;
+    ~InputPort();
+    // A port reading the file called fileName.
+    static shared_ptr<InputPort> open(const string& fileName);
+
+    // The next line without its line ending, or nullopt at the end of the input. The view is into the
+    // port's buffer, and good only until the port is read again.
+    std::optional<std::string_view> readLine();
+    std::optional<char> readChar();
+    std::optional<char> peekChar();
+    // The next datum, or nullptr at the end of the input. Only the text of the datum is taken, so
+    // lines or characters can be read from just after it.
+    ValuePtr read();
+    void close();
+
+    bool isOpen() const { return !isClosed; }
+};
+
+// The lines of a file, without their line endings, for going through once. A regular file is mapped
+// and its lines are views into the mapping, found with memchr; anything else, such as a pipe, is read
+// through an InputPort.
+class LineSource
+{
+    static constexpr size_t ReleaseStep = 1 << 24;
+
+    shared_ptr<MappedFile> mappedFile;
+    std::string_view mappedText;
+    size_t pos = 0;
+    // Mapped pages before this have been let go, so a large file does not fill the working set.
+    size_t released = 0;
+    shared_ptr<InputPort> port;
+public:
+    explicit LineSource(const string& fileName);
+    // The next line, good until the next call, or nullopt at the end.
+    std::optional<std::string_view> next();
+};
+
+// A port as a value: an input port or an output port. Copies share the port, which keeps its
+// identity.
+class PortValue
+    :public Value
+{
+    shared_ptr<OutputPort> outputPort;
+    shared_ptr<InputPort> inputPort;
+public:
+    explicit PortValue(shared_ptr<OutputPort> port)
+        :outputPort{ std::move(port) } {}
+    explicit PortValue(shared_ptr<InputPort> port)
+        :inputPort{ std::move(port) } {}
+    string toString() const override;
+    int getTypeID() const override;
+    // The port, or nullptr if it is the other kind.
+    OutputPort* output() const;
+    InputPort* input() const;
+    ValuePtr copy() const override;
+};
+
+// The port display and friends write to when they are given none: standard output, flushed at exit,
+// before anything is read from standard input, and before an error is reported.
+OutputPort& currentOutputPort();
+shared_ptr<OutputPort> currentOutputPortPtr();
+
+// Makes port the current output port until destroyed, when the previous one is restored; an error
+// thrown through it cannot leave output captured.
+class OutputRedirection
+{
+    shared_ptr<OutputPort> previous;
+public:
+    explicit OutputRedirection(shared_ptr<OutputPort> port);
+    OutputRedirection(const OutputRedirection&) = delete;
+    OutputRedirection& operator=(const OutputRedirection&) = delete;
+    ~OutputRedirection();
+};
+
+// The port read-line and friends read from when they are given none: the standard input. It has a
+// buffer of its own, apart from the reader (read) without a port uses.
+shared_ptr<InputPort> currentInputPortPtr();
+
+#endif // !PORT_H
@@ -0,0 +1,294 @@
+#include "./printer.h"
+
+namespace
+{
+    constexpr int CompoundType = ValueType::PairType | ValueType::VectorType;
+
+    bool isCompound(const Value& value)
+    {
+        return value.getTypeID() & CompoundType;
+    }
+}
+
+void Printer::findLabels(const Value& root, bool labelShared)
+{
+    // A depth-first walk that marks the pairs and vectors still being visited, so reaching one of them
+    // again means a cycle. Only objects with more than one owner can be reached twice, and every cycle
+    // passes through one (the object it is entered at is owned from outside it as well), so the rest
+    // are walked without entering the table.
+    marks.clear();
+    visits.push_back({ &root, true, false });
+    while (!visits.empty())
+    {
+        auto [value, isTracked, isExit] = visits.back();
+        visits.pop_back();
+        if (isExit)
+        {
+            marks[value].isDone = true;
+            continue;
+        }
+        auto visit = [this](const ValuePtr& child)
+        {
+            if (isCompound(*child))
+                visits.push_back({ child.get(), child.use_count() > 1, false });
+        };
+        // An untracked cdr is followed in place, so a long list does not pass through the stack.
+        while (value)
+        {
+            if (isTracked)
+            {
+                auto [it, isNew] = marks.try_emplace(value);
+                if (!isNew)
+                {
+                    if (!it->second.isDone || labelShared)
+                        it->second.isLabeled = hasLabels = true;
+                    break;
+                }
+                visits.push_back({ value, true, true });
+            }
+            if (value->getTypeID() != ValueType::PairType)
+            {
+                auto& items = static_cast<const VectorValue&>(*value).value();
+                for (auto it = items.rbegin(); it != items.rend(); ++it)
+                    visit(*it);
+                break;
+            }
+            auto& pair = static_cast<const PairValue&>(*value);
+            visit(pair.left());
+            auto& rest = pair.right();
+            value = isCompound(*rest) ? rest.get() : nullptr;
+            isTracked = rest.use_count() > 1;
+        }
+    }
+}
+
+Printer::Mark* Printer::labelOf(const Value& value)
+{
+    if (!hasLabels)
+        return nullptr;
+    auto it = marks.find(&value);
+    return it != marks.end() && it->second.isLabeled ? &it->second : nullptr;
+}
+
+void Printer::enter(const Value& value, bool isTracked)
+{
+    // Without labels, the shared objects being printed are watched instead, so a cycle is noticed when
+    // it comes back to one of them.
+    if (!isWatching || !isTracked)
+        return;
+    auto [it, isNew] = marks.try_emplace(&value);
+    if (isNew)
+        openMarks.push_back(&it->second);
+    else if (!it->second.isDone)
+        hasCycle = true;
+}
+
+void Printer::close(std::string& out, size_t opened, const char* text)
+{
+    out += text;
+    for (; openMarks.size() > opened; openMarks.pop_back())
+        openMarks.back()->isDone = true;
+}
+
+void Printer::printAtom(std::string& out, const Value& value, int type, const PrintOptions& options)
+{
+    switch (type)
+    {
+    case ValueType::StringType:
+    {
+        auto& text = static_cast<const StringValue&>(value).value();
+        if (options.isDisplay)
+            out += text;
+        else
+            appendEscaped(out, text);
+        return;
+    }
+    case ValueType::NumericType:
+        static_cast<const NumericValue&>(value).value().appendTo(out);
+        return;
+    default:
+        out += options.isDisplay ? value.toDisplayString() : value.toString();
+        return;
+    }
+}
+
+void Printer::printValue(std::string& out, const Value& value, bool isTracked, size_t depth, const PrintOptions& options)
+{
+    int type = value.getTypeID();
+    if (!(type & CompoundType))
+    {
+        printAtom(out, value, type, options);
+        return;
+    }
+    if (depth >= options.maxDepth)
+    {
+        out += "...";
+        return;
+    }
+    if (auto mark = labelOf(value))
+    {
+        out += '#';
+        if (mark->label >= 0)
+        {
+            out += std::to_string(mark->label);
+            out += '#';
+            return;
+        }
+        mark->label = nextLabel++;
+        out += std::to_string(mark->label);
+        out += '=';
+    }
+    size_t opened = openMarks.size();
+    enter(value, isTracked);
+    bool isPair = type == ValueType::PairType;
+    out += isPair ? "(" : "#(";
+    tasks.push_back({ isPair ? Step::ListItem : Step::VectorItem, false, &value, 0, depth + 1, opened });
+}
+
+bool Printer::nextPair(std::string& out, const PairValue*& pair, size_t depth, size_t opened)
+{
+    // The list goes on through the cdr unless that is labeled, and so has to be printed as an object.
+    auto& rest = pair->right();
+    int type = rest->getTypeID();
+    if (type == ValueType::NilType)
+    {
+        close(out, opened, ")");
+        return false;
+    }
+    if (type == ValueType::PairType && !labelOf(*rest))
+    {
+        out += ' ';
+        pair = static_cast<const PairValue*>(rest.get());
+        enter(*pair, rest.use_count() > 1);
+        return true;
+    }
+    out += " . ";
+    tasks.push_back({ Step::Close, false, nullptr, 0, 0, opened });
+    tasks.push_back({ Step::Value, rest.use_count() > 1, rest.get(), 0, depth, 0 });
+    return false;
+}
+
+bool Printer::printOnce(std::string& out, const Value& value, const PrintOptions& options)
+{
+    nextLabel = 0;
+    hasCycle = false;
+    tasks.push_back({ Step::Value, true, &value, 0, 0, 0 });
+    while (!tasks.empty() && !hasCycle)
+    {
+        auto [step, isTracked, current, index, depth, opened] = tasks.back();
+        tasks.pop_back();
+        switch (step)
+        {
+        case Step::Value:
+            printValue(out, *current, isTracked, depth, options);
+            break;
+        case Step::ListItem:
+        case Step::ListTail:
+        {
+            // Runs of atoms along the spine are printed here directly; an element that is itself a
+            // pair or vector is handed to the stack, and the list resumes at its ListTail.
+            auto pair = static_cast<const PairValue*>(current);
+            if (step == Step::ListTail && !nextPair(out, pair, depth, opened))
+                break;
+            while (!hasCycle)
+            {
+                if (index == options.maxLength)
+                {
+                    close(out, opened, "...)");
+                    break;
+                }
+                auto& item = pair->left();
+                int type = item->getTypeID();
+                index++;
+                if (type & CompoundType)
+                {
+                    tasks.push_back({ Step::ListTail, false, pair, index, depth, opened });
+                    tasks.push_back({ Step::Value, item.use_count() > 1, item.get(), 0, depth, 0 });
+                    break;
+                }
+                printAtom(out, *item, type, options);
+                if (!nextPair(out, pair, depth, opened))
+                    break;
+            }
+            break;
+        }
+        case Step::VectorItem:
+        {
+            auto& items = static_cast<const VectorValue*>(current)->value();
+            if (index == items.size())
+            {
+                close(out, opened, ")");
+                break;
+            }
+            if (index > 0)
+                out += ' ';
+            if (index == options.maxLength)
+            {
+                close(out, opened, "...)");
+                break;
+            }
+            auto& item = items[index];
+            tasks.push_back({ Step::VectorItem, false, current, index + 1, depth, opened });
+            tasks.push_back({ Step::Value, item.use_count() > 1, item.get(), 0, depth, 0 });
+            break;
+        }
+        case Step::Close:
+            close(out, opened, ")");
+            break;
+        }
+    }
+    tasks.clear();
+    openMarks.clear();
+    return !hasCycle;
+}
+
+void Printer::print(std::string& out, const Value& value, const PrintOptions& options)
+{
+    // Most values have no cycle and are printed in one pass that watches for one. Only when it finds
+    // one, or when every shared object is to be labeled, are the labels worked out first.
+    size_t start = out.size();
+    marks.clear();
+    hasLabels = false;
+    isWatching = !options.labelShared;
+    if (options.labelShared || !printOnce(out, value, options))
+    {
+        out.resize(start);
+        isWatching = false;
+        findLabels(value, options.labelShared);
+        printOnce(out, value, options);
+    }
+}
+
+void Printer::appendEscaped(std::string& out, std::string_view text)
+{
+    out += '"';
+    for (size_t start = 0; start < text.size();)
+    {
+        size_t end = text.find_first_of("\"\\", start);
+        if (end == std::string_view::npos)
+            end = text.size();
+        out += text.substr(start, end - start);
+        if (end < text.size())
+        {
+            out += '\\';
+            out += text[end];
+            end++;
+        }
+        start = end;
+    }
+    out += '"';
+}
+
+std::string Printer::toString(const Value& value)
+{
+    std::string result;
+    Printer().print(result, value);
+    return result;
+}
+
+std::string Printer::toDisplayString(const Value& value)
+{
+    std::string result;
+    Printer().print(result, value, { .isDisplay = true });
+    return result;
+}
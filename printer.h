@@ -0,0 +1,93 @@
+#ifndef PRINTER_H
+#define PRINTER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "./value.h"
+
+// How a value is printed.
+struct PrintOptions
+{
+    // The display form: strings and characters as their contents, rather than as literals.
+    bool isDisplay = false;
+    // Label every pair or vector that is reached more than once (write-shared), not only the ones on a cycle.
+    bool labelShared = false;
+    // Lists and vectors show at most this many elements, then "...".
+    size_t maxLength = SIZE_MAX;
+    // Lists and vectors nested this deep show as "...".
+    size_t maxDepth = SIZE_MAX;
+};
+
+// Prints values into a string with explicit stacks instead of recursion, so a long list costs linear
+// time and a deeply nested one no native stack. Pairs and vectors on a cycle get datum labels (#0= at the
+// first occurrence, #0# after), so circular structure prints finitely. A Printer keeps its work space
+// between calls.
+class Printer
+{
+    struct Mark
+    {
+        bool isDone = false;
+        bool isLabeled = false;
+        long long label = -1;
+    };
+    struct Visit
+    {
+        const Value* value;
+        bool isTracked;
+        bool isExit;
+    };
+    enum class Step : uint8_t
+    {
+        Value,
+        ListItem,
+        ListTail,
+        VectorItem,
+        Close,
+    };
+    struct Task
+    {
+        Step step;
+        // Whether value has other owners, and so could be on a cycle (Value only).
+        bool isTracked;
+        const Value* value;
+        size_t index;
+        size_t depth;
+        // How many objects were open when the list or vector was entered (all but Value).
+        size_t opened;
+    };
+
+    std::unordered_map<const Value*, Mark> marks;
+    std::vector<Visit> visits;
+    std::vector<Task> tasks;
+    // The marks of the shared objects being printed, innermost last.
+    std::vector<Mark*> openMarks;
+    bool hasLabels = false;
+    bool isWatching = false;
+    bool hasCycle = false;
+    long long nextLabel = 0;
+
+    void findLabels(const Value& root, bool labelShared);
+    Mark* labelOf(const Value& value);
+    void enter(const Value& value, bool isTracked);
+    // Ends a list or vector with text, and with it the objects opened since opened.
+    void close(std::string& out, size_t opened, const char* text);
+    // After the element of pair: moves pair to the next one and returns true, or ends the list.
+    bool nextPair(std::string& out, const PairValue*& pair, size_t depth, size_t opened);
+    void printAtom(std::string& out, const Value& value, int type, const PrintOptions& options);
+    void printValue(std::string& out, const Value& value, bool isTracked, size_t depth, const PrintOptions& options);
+    // Returns false, having stopped part way, if it came across a cycle without labels.
+    bool printOnce(std::string& out, const Value& value, const PrintOptions& options);
+public:
+    void print(std::string& out, const Value& value, const PrintOptions& options = {});
+
+    // The write form of text: quoted, with '"' and '\' escaped.
+    static void appendEscaped(std::string& out, std::string_view text);
+    static std::string toString(const Value& value);
+    static std::string toDisplayString(const Value& value);
+};
+
+#endif // !PRINTER_H
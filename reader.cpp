@@ -1,7 +1,165 @@
 #include "reader.h"
 
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "./simd.h"
+
+// Whitespace and the characters that end an atom, matching the tokenizer.
+static constexpr std::array<bool, 256> atomEnds = [] {
+    std::array<bool, 256> table{};
+    for (unsigned char c : { ' ', '\t', '\n', '\v', '\f', '\r', '(', ')', '\'', '`', ',', '"' })
+        table[c] = true;
+    return table;
+}();
+
+static bool endsAtom(char c)
+{
+    return atomEnds[static_cast<unsigned char>(c)];
+}
+
+bool DatumScanner::completesDatum()
+{
+    if (depth > 0)
+        return false;
+    pendingPrefix = false;
+    return true;
+}
+
+size_t DatumScanner::scan(std::string_view text, size_t from, size_t boundary)
+{
+    for (size_t pos = from; pos < text.size(); pos++)
+    {
+        if (state == State::Atom)
+        {
+            while (pos < text.size() && !endsAtom(text[pos]))
+                pos++;
+            if (pos == text.size())
+                break;
+        }
+        char c = text[pos];
+        switch (state)
+        {
+        case State::Comment:
+        {
+            pos = Simd::findClass(text.data(), pos, text.size(), Simd::Newline);
+            if (pos < text.size())
+                state = State::Between;
+            break;
+        }
+        case State::String:
+        {
+            pos = Simd::findClass(text.data(), pos, text.size(), Simd::Quote | Simd::Backslash);
+            if (pos == text.size())
+                break;
+            if (text[pos] == '\\')
+            {
+                state = State::StringEscape;
+            }
+            else
+            {
+                state = State::Between;
+                if (completesDatum())
+                    boundary = pos + 1;
+            }
+            break;
+        }
+        case State::StringEscape:
+        {
+            state = State::String;
+            break;
+        }
+        case State::CharStart:
+        {
+            // The first character of a character literal is taken as is, so #\( and #\  work.
+            state = State::Atom;
+            break;
+        }
+        case State::Hash:
+        {
+            if (c == '(')
+            {
+                depth++;
+                state = State::Between;
+                break;
+            }
+            if (c == '\\')
+            {
+                state = State::CharStart;
+                break;
+            }
+            state = State::Atom;
+            [[fallthrough]];
+        }
+        case State::Atom:
+        {
+            if (!endsAtom(c))
+                break;
+            state = State::Between;
+            if (completesDatum())
+                boundary = pos;
+            [[fallthrough]];
+        }
+        case State::Between:
+        {
+            switch (c)
+            {
+            case ';': state = State::Comment; break;
+            case '"': state = State::String; break;
+            case '#': state = State::Hash; break;
+            case '(': depth++; break;
+            case ')':
+            {
+                // A stray paren at top level also ends a "datum", so the parser gets to report it.
+                if (depth > 0)
+                    depth--;
+                if (completesDatum())
+                    boundary = pos + 1;
+                break;
+            }
+            case '\'': case '`': case ',':
+            {
+                if (depth == 0)
+                    pendingPrefix = true;
+                break;
+            }
+            default:
+            {
+                if (!endsAtom(c))
+                    state = State::Atom;
+                break;
+            }
+            }
+            break;
+        }
+        }
+    }
+    return boundary;
+}
+
+size_t DatumScanner::scanFirst(std::string_view text, size_t from)
+{
+    // A byte at a time, so the scan stops where the datum does.
+    for (; from < text.size(); from++)
+    {
+        size_t end = scan(text.substr(0, from + 1), from, SIZE_MAX);
+        if (end != SIZE_MAX)
+            return end;
+    }
+    return SIZE_MAX;
+}
+
+bool DatumScanner::isInsideDatum() const
+{
+    return depth > 0 || pendingPrefix || (state != State::Between && state != State::Comment);
+}
+
 Reader::Reader(const std::string& fileName)
+    :mappedSource{ MappedFile::open(fileName) }, isInteractive{ false }
 {
+    if (mappedSource)
+        return;
     sourceFile.open(fileName);
     if (!sourceFile.is_open())
         throw InterpreterError("Open file \"" + fileName + "\" failed");
@@ -11,7 +169,10 @@ Reader::Reader(const std::string& fileName)
 ValuePtr Reader::read()
 {
     while (isEmpty())
-        tokenizeAndParseLine();
+    {
+        if (!readChunk() && isEmpty())
+            throw LispError("Unexpected end of input");
+    }
     auto result = values[0];
     values.pop_front();
     return result;
@@ -27,34 +188,201 @@ bool Reader::isEmpty()
     return values.empty();
 }
 
-bool Reader::tokenizeAndParseLine()
+bool Reader::readChunk()
+{
+    SourceChunk chunk;
+    bool hasMore = takeChunk(chunk);
+    Parser parser(chunk.text());
+    while (!parser.isEmpty())
+        values.push_back(parser.parse());
+    release(chunk.end);
+    return hasMore;
+}
+
+bool Reader::takeChunk(SourceChunk& chunk)
+{
+    bool hasMore = mappedSource ? readMapped() : isInteractive ? readLine() : readBlock();
+    auto text = pending();
+    complete = scanner.scan(text, scanned, complete);
+    scanned = text.size();
+    if (hasMore)
+    {
+        take(complete, chunk);
+    }
+    else
+    {
+        scanner.reset();
+        take(scanned, chunk);
+    }
+    return hasMore;
+}
+
+void Reader::release(size_t offset)
+{
+    if (mappedSource)
+        mappedSource->release(offset);
+}
+
+bool Reader::isInsideDatum() const
+{
+    return scanner.isInsideDatum();
+}
+
+void Reader::discardPending()
+{
+    values = {};
+    buffer.clear();
+    consumed += mappedLength;
+    mappedLength = scanned = complete = 0;
+    scanner.reset();
+}
+
+std::istream& Reader::inputStream()
+{
+    return *pSource;
+}
+
+bool Reader::readMapped()
+{
+    // Nothing is copied: the next block of the mapping simply becomes pending input.
+    size_t rest = mappedSource->view().size() - consumed;
+    mappedLength = std::min(mappedLength + BlockSize, rest);
+    return mappedLength < rest;
+}
+
+bool Reader::readBlock()
+{
+    size_t oldSize = buffer.size();
+    buffer.resize(oldSize + BlockSize);
+    inputStream().read(buffer.data() + oldSize, BlockSize);
+    buffer.resize(oldSize + inputStream().gcount());
+    return inputStream().good();
+}
+
+bool Reader::readLine()
 {
-    bool ret = true;
     string line;
     getline(inputStream(), line);
-    if (inputStream().eof())
+    buffer += line;
+    buffer += '\n';
+    return inputStream().good();
+}
+
+std::string_view Reader::pending() const
+{
+    if (!mappedSource)
+        return buffer;
+    return mappedSource->view().substr(consumed, mappedLength);
+}
+
+void Reader::take(size_t end, SourceChunk& chunk)
+{
+    // A buffer is about to be overwritten, so its text is copied out; a mapping stays put.
+    if (mappedSource)
+    {
+        chunk.mappedText = pending().substr(0, end);
+        mappedLength -= end;
+    }
+    else
     {
-        ret = false;
-        if (line.size() == 0)
+        chunk.copiedText = buffer.substr(0, end);
+        buffer.erase(0, end);
+    }
+    consumed += end;
+    scanned -= end;
+    complete -= end;
+    chunk.end = consumed;
+}
+
+PrefetchReader::PrefetchReader(const std::string& fileName)
+    :reader{ fileName }, maxWorkers{ std::max(std::thread::hardware_concurrency(), 2u) - 1 },
+    splitter{ [this](std::stop_token stop) { split(stop); } } {}
+
+ValuePtr PrefetchReader::next()
+{
+    std::unique_lock lock(mutex);
+    while (true)
+    {
+        changed.wait(lock, [this] { return batches.empty() ? isSplit : batches.front()->isParsed; });
+        if (batches.empty())
+            return nullptr;
+        auto& batch = *batches.front();
+        if (!batch.values.empty())
         {
-            return false;
+            auto value = std::move(batch.values.front());
+            batch.values.pop_front();
+            return value;
         }
+        auto failure = batch.failure;
+        reader.release(batch.source.end);
+        batches.pop_front();
+        // Room for the splitter to cut another chunk.
+        changed.notify_all();
+        if (failure)
+            std::rethrow_exception(failure);
     }
-    auto tokens = Tokenizer::tokenize(line);
-    Parser parser(std::move(tokens));
-    while (!parser.isEmpty())
-        values.push_back(parser.parse());
-    return ret;
 }
 
-void Reader::cleanUpValueList()
+void PrefetchReader::split(std::stop_token stop)
 {
-    values = {};
+    bool hasMore = true;
+    while (hasMore && !stop.stop_requested())
+    {
+        auto batch = make_shared<Batch>();
+        // Scanning is much faster than parsing, so one thread keeps the whole pool busy.
+        do
+            hasMore = reader.takeChunk(batch->source);
+        while (hasMore && batch->source.text().empty());
+        if (batch->source.text().empty())
+            break;
+        {
+            std::unique_lock lock(mutex);
+            if (!changed.wait(lock, stop, [this] { return batches.size() < maxWorkers * BatchesPerWorker; }))
+                return;
+            batches.push_back(batch);
+            unclaimed.push_back(batch);
+            // Workers are started as chunks appear, so a short script does not pay for a full pool.
+            if (workers.size() < maxWorkers && workers.size() < batches.size())
+                workers.emplace_back([this](std::stop_token stop) { parse(stop); });
+        }
+        changed.notify_all();
+    }
+    {
+        std::lock_guard lock(mutex);
+        isSplit = true;
+    }
+    changed.notify_all();
 }
 
-std::istream& Reader::inputStream()
+void PrefetchReader::parse(std::stop_token stop)
 {
-    return *pSource;
+    while (true)
+    {
+        shared_ptr<Batch> batch;
+        {
+            std::unique_lock lock(mutex);
+            if (!changed.wait(lock, stop, [this] { return !unclaimed.empty() || isSplit; }) || unclaimed.empty())
+                return;
+            batch = std::move(unclaimed.front());
+            unclaimed.pop_front();
+        }
+        try
+        {
+            Parser parser(batch->source.text());
+            while (!parser.isEmpty())
+                batch->values.push_back(parser.parse());
+        }
+        catch (...)
+        {
+            // The data before the error are still delivered first.
+            batch->failure = std::current_exception();
+        }
+        {
+            std::lock_guard lock(mutex);
+            batch->isParsed = true;
+        }
+        changed.notify_all();
+    }
 }
 
 std::shared_ptr<Reader> stdinReader = std::make_shared<Reader>();
@@ -8,35 +8,160 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <cstdint>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
 
 #include "./token.h"
 #include "./tokenizer.h"
 #include "./parser.h"
 #include "./error.h"
+#include "./mapped_file.h"
 
+// Finds where complete top-level data end in input that arrives in pieces. Its state carries over
+// between calls, so each byte is looked at once however a datum is split across chunks. It only
+// tracks nesting, strings, comments and atom boundaries; the tokenizer and parser do the real checking.
+class DatumScanner
+{
+    enum class State : uint8_t
+    {
+        Between,
+        Atom,
+        Hash,
+        CharStart,
+        String,
+        StringEscape,
+        Comment
+    };
+    State state = State::Between;
+    size_t depth = 0;
+    // A quote-like prefix at top level is waiting for its datum.
+    bool pendingPrefix = false;
+
+    bool completesDatum();
+public:
+    // Continues over text[from, text.size()) and returns the end of the last top-level datum completed
+    // there, or boundary if none was.
+    size_t scan(std::string_view text, size_t from, size_t boundary);
+    // Continues over text[from, text.size()) and returns the end of the first top-level datum completed
+    // there, or SIZE_MAX if none is, for a caller that wants one datum and must leave the input after it.
+    size_t scanFirst(std::string_view text, size_t from);
+    // Whether the input scanned so far ends inside an unfinished datum.
+    bool isInsideDatum() const;
+    void reset() { *this = DatumScanner(); }
+};
+
+// Complete top-level data taken from a Reader's input, left for the caller to parse.
+struct SourceChunk
+{
+    // The text points into the mapped file, or was copied out of a read buffer.
+    std::string_view mappedText;
+    std::string copiedText;
+    // Input offset just past the text.
+    size_t end = 0;
+
+    std::string_view text() const { return mappedText.empty() ? std::string_view(copiedText) : mappedText; }
+};
+
+// Reads data from a file or stdin. Regular files are memory-mapped and parsed in place, 64 KB at a time;
+// other files are read in 64 KB blocks, and stdin a line at a time so interactive input is handled as
+// soon as it is entered. Either way a datum may span chunks.
 class Reader
 {
+    static constexpr size_t BlockSize = 64 * 1024;
+
     std::istream* pSource;
     std::ifstream sourceFile;
-    std::string currentLine;
+    shared_ptr<MappedFile> mappedSource;
+    bool isInteractive;
+    // Input read but not yet parsed: mappedLength bytes of the mapping past consumed, or else the buffer.
+    // The first scanned bytes of it have been through the scanner; the first complete bytes hold
+    // only complete data.
+    std::string buffer;
+    size_t consumed = 0;
+    size_t mappedLength = 0;
+    size_t scanned = 0;
+    size_t complete = 0;
+    DatumScanner scanner;
     std::deque<ValuePtr> values;
 public:
     Reader()
-        :pSource{ &std::cin } {}
+        :pSource{ &std::cin }, isInteractive{ true } {}
     Reader(const std::string& fileName);
     ValuePtr read();
     std::deque<ValuePtr>& getAllValues();
     bool isEmpty();
-    bool tokenizeAndParseLine();
-    void cleanUpValueList();
+    // Reads the next chunk of input and parses every datum it completes. Returns false at end of input,
+    // after handing any unfinished datum to the parser so that it reports what is missing.
+    bool readChunk();
+    // Like readChunk, but hands the complete data over unparsed, so they can be parsed on another thread.
+    bool takeChunk(SourceChunk& chunk);
+    // The caller is done with input before offset; mapped pages there may be dropped.
+    void release(size_t offset);
+    // Whether the input read so far ends inside an unfinished datum.
+    bool isInsideDatum() const;
+    // Drops parsed values and unparsed input, e.g. after a syntax error.
+    void discardPending();
 
 private:
     std::istream& inputStream();
+    bool readMapped();
+    bool readBlock();
+    bool readLine();
+    std::string_view pending() const;
+    void take(size_t end, SourceChunk& chunk);
+};
 
+// A source of top-level forms for file mode.
+class FormReader
+{
+public:
+    virtual ~FormReader() = default;
+    // The next form, or nullptr at the end.
+    virtual ValuePtr next() = 0;
 };
 
-extern shared_ptr<Reader> stdinReader;
+// Parses a file in parallel while the caller evaluates what has been read so far. A splitter thread cuts
+// the input into chunks at top-level datum boundaries, a pool of workers parses them concurrently, and
+// next() returns the data in source order. Only a few chunks per worker are in flight at once, so memory
+// does not grow with the file.
+class PrefetchReader
+    :public FormReader
+{
+    struct Batch
+    {
+        SourceChunk source;
+        std::deque<ValuePtr> values;
+        std::exception_ptr failure;
+        bool isParsed = false;
+    };
+    static constexpr size_t BatchesPerWorker = 2;
 
-#endif // !READER_H
+    Reader reader;
+    size_t maxWorkers;
+    std::mutex mutex;
+    std::condition_variable_any changed;
+    // In source order; the front one is being consumed.
+    std::deque<shared_ptr<Batch>> batches;
+    std::deque<shared_ptr<Batch>> unclaimed;
+    bool isSplit = false;
+    // Declared last: the threads start after the members above are ready and are joined, splitter
+    // first, before those go away.
+    std::vector<std::jthread> workers;
+    std::jthread splitter;
 
+    void split(std::stop_token stop);
+    void parse(std::stop_token stop);
+public:
+    PrefetchReader(const std::string& fileName);
+    // A syntax error is rethrown once every datum before it has been returned.
+    ValuePtr next() override;
+};
 
+extern shared_ptr<Reader> stdinReader;
+
+#endif // !READER_H
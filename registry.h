@@ -0,0 +1,160 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#include "./value.h"
+
+// Parameter types of a table entry, kept in static storage so the entry can refer to them.
+template<int... Types>
+inline constexpr std::array<int, sizeof...(Types)> paramTypes{ Types... };
+
+// One entry of the builtin or special form table.
+struct ProcSpec
+{
+    std::string_view name;
+    FuncType func;
+    int minArgs = CallableValue::UnlimitedCnt;
+    int maxArgs = CallableValue::UnlimitedCnt;
+    std::span<const int> paramTypes = CallableValue::UnlimitedType;
+};
+
+// A perfect hash of N names, found at compile time: each name has a slot of its own in a table with
+// room for about twice as many, so a lookup is one hash, one probe and one comparison.
+// Names are first hashed into buckets; then, fullest bucket first, each bucket gets the first seed
+// that sends all of its names to free slots.
+template<size_t N>
+class PerfectHash
+{
+    static constexpr size_t BucketCount = std::max<size_t>(std::bit_ceil(N) / 2, 1);
+    static constexpr int SlotBits = std::countr_zero(std::bit_ceil(N)) + 1;
+    static constexpr size_t SlotCount = size_t(1) << SlotBits;
+    static constexpr uint16_t Empty = UINT16_MAX;
+    static_assert(N < Empty);
+
+    std::array<uint16_t, BucketCount> seeds{};
+    std::array<uint16_t, SlotCount> indices{};
+
+    static constexpr uint64_t hash(std::string_view name)
+    {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (char c : name)
+            h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        return h;
+    }
+    static constexpr size_t bucketOf(uint64_t h) { return h & (BucketCount - 1); }
+    static constexpr size_t slotOf(uint64_t h, uint64_t seed)
+    {
+        return ((h ^ (seed * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull) >> (64 - SlotBits);
+    }
+
+    // Finds a seed that sends names order[begin..end), all of one bucket, to free slots, and takes them.
+    constexpr uint16_t place(const std::array<uint64_t, N>& hashes, const std::array<size_t, N>& order, size_t begin, size_t end)
+    {
+        for (uint16_t seed = 0; seed < UINT16_MAX; seed++)
+        {
+            size_t placed = begin;
+            for (; placed < end; placed++)
+            {
+                auto& index = indices[slotOf(hashes[order[placed]], seed)];
+                if (index != Empty)
+                    break;
+                index = static_cast<uint16_t>(order[placed]);
+            }
+            if (placed == end)
+                return seed;
+            while (placed-- > begin)
+                indices[slotOf(hashes[order[placed]], seed)] = Empty;
+        }
+        throw "No perfect hash found; are two names the same?";
+    }
+public:
+    constexpr PerfectHash(const std::array<std::string_view, N>& names)
+    {
+        indices.fill(Empty);
+        std::array<uint64_t, N> hashes{};
+        std::array<size_t, BucketCount> sizes{};
+        for (size_t i = 0; i < N; i++)
+        {
+            hashes[i] = hash(names[i]);
+            sizes[bucketOf(hashes[i])]++;
+        }
+        std::array<size_t, N> order{};
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs)
+        {
+            size_t lhsBucket = bucketOf(hashes[lhs]), rhsBucket = bucketOf(hashes[rhs]);
+            return sizes[lhsBucket] != sizes[rhsBucket] ? sizes[lhsBucket] > sizes[rhsBucket] : lhsBucket < rhsBucket;
+        });
+        for (size_t begin = 0, end = 0; begin < N; begin = end)
+        {
+            size_t bucket = bucketOf(hashes[order[begin]]);
+            while (end < N && bucketOf(hashes[order[end]]) == bucket)
+                end++;
+            seeds[bucket] = place(hashes, order, begin, end);
+        }
+    }
+
+    // The index of the only name that may equal name, or N; the caller still has to compare.
+    constexpr size_t find(std::string_view name) const
+    {
+        uint64_t h = hash(name);
+        uint16_t index = indices[slotOf(h, seeds[bucketOf(h)])];
+        return index == Empty ? N : index;
+    }
+};
+
+// A table of procedures built entirely at compile time: the objects live in static storage, so
+// nothing is constructed at startup and they outlive every reference to them.
+template<typename Proc, size_t N>
+class Registry
+{
+    std::array<std::string_view, N> names;
+    PerfectHash<N> hash;
+    std::array<Proc, N> procs;
+
+    template<size_t... I>
+    static constexpr std::array<std::string_view, N> namesOf(const ProcSpec (&specs)[N], std::index_sequence<I...>)
+    {
+        return { specs[I].name... };
+    }
+    template<size_t... I>
+    static constexpr std::array<Proc, N> procsOf(const ProcSpec (&specs)[N], std::index_sequence<I...>)
+    {
+        return { Proc(specs[I].func, specs[I].minArgs, specs[I].maxArgs, specs[I].paramTypes)... };
+    }
+public:
+    constexpr Registry(const ProcSpec (&specs)[N])
+        :names{ namesOf(specs, std::make_index_sequence<N>{}) }, hash{ names },
+        procs{ procsOf(specs, std::make_index_sequence<N>{}) } {}
+
+    // The procedure called name, or nullptr. The pointer has no owner (an aliasing pointer to an
+    // empty one), so copying it costs no reference counting.
+    shared_ptr<Proc> find(std::string_view name)
+    {
+        size_t index = hash.find(name);
+        if (index == N || names[index] != name)
+            return nullptr;
+        return shared_ptr<Proc>(shared_ptr<Proc>(), &procs[index]);
+    }
+
+    // The name value was registered under, or an empty view if it is not one of the procedures.
+    std::string_view nameOf(const Value& value) const
+    {
+        std::less<const Value*> isBefore;
+        if (isBefore(&value, procs.data()) || !isBefore(&value, procs.data() + N))
+            return {};
+        return names[static_cast<const Proc*>(&value) - procs.data()];
+    }
+};
+
+#endif // !REGISTRY_H
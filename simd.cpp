@@ -0,0 +1,887 @@
+#include "./simd.h"
+
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef MINI_LISP_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SIMD_TARGET_AVX
+#define SIMD_TARGET_AVX2
+#define SIMD_INLINE __forceinline
+#else
+#define SIMD_TARGET_AVX __attribute__((target("avx")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#define SIMD_INLINE inline __attribute__((always_inline))
+#endif
+#endif
+
+namespace Simd
+{
+    namespace
+    {
+        struct Kernels
+        {
+            void (*add)(const double*, const double*, double*, size_t);
+            void (*scale)(const double*, double, double*, size_t);
+            double (*dot)(const double*, const double*, size_t);
+            double (*sum)(const double*, size_t);
+            double (*min)(const double*, size_t);
+            double (*max)(const double*, size_t);
+            bool (*map)(UnaryOp, const double*, double*, size_t);
+            void (*axpy)(double, const double*, double*, size_t);
+            // c[rows x width] += a[rows x depth] * b[depth x width], with leading dimensions lda/ldb/ldc.
+            void (*gemmBlock)(const double*, const double*, double*, size_t, size_t, size_t, size_t, size_t, size_t);
+        };
+
+        // Block sizes for matmul, chosen so one block of b stays in L2.
+        constexpr size_t RowBlock = 64;
+        constexpr size_t InnerBlock = 256;
+        constexpr size_t ColBlock = 512;
+        constexpr size_t TransposeBlock = 32;
+        // Below this many multiply-adds, spawning threads costs more than it saves.
+        constexpr size_t ParallelThreshold = size_t(1) << 22;
+
+        double scalarApply(UnaryOp op, double x)
+        {
+            switch (op)
+            {
+            case UnaryOp::Abs: return std::abs(x);
+            case UnaryOp::Negate: return -x;
+            case UnaryOp::Square: return x * x;
+            case UnaryOp::Sqrt: return std::sqrt(x);
+            case UnaryOp::Floor: return std::floor(x);
+            case UnaryOp::Ceiling: return std::ceil(x);
+            case UnaryOp::Round: return std::nearbyint(x);
+            case UnaryOp::Exp: return std::exp(x);
+            case UnaryOp::Log: return std::log(x);
+            case UnaryOp::Sin: return std::sin(x);
+            case UnaryOp::Cos: return std::cos(x);
+            }
+            return x;
+        }
+
+        // Lexer byte classes, indexed by unsigned char.
+        constexpr std::array<unsigned char, 256> charClasses = [] {
+            std::array<unsigned char, 256> table{};
+            for (unsigned char c : { ' ', '\t', '\n', '\v', '\f', '\r' })
+                table[c] |= Whitespace;
+            for (unsigned char c : { '(', ')', '\'', '`', ',', '"' })
+                table[c] |= Delimiter;
+            table['"'] |= Quote;
+            table['\\'] |= Backslash;
+            table['\n'] |= Newline;
+            return table;
+        }();
+
+        struct ScanKernels
+        {
+            uint64_t (*classBits)(const char*, unsigned);
+            size_t (*find)(const char*, size_t, size_t, unsigned);
+            size_t (*search)(const char*, size_t, size_t, const char*, size_t);
+            int (*compareFolded)(const char*, const char*, size_t);
+        };
+
+        namespace Scalar
+        {
+            uint64_t classBits(const char* data, size_t n, unsigned mask)
+            {
+                uint64_t bits = 0;
+                for (size_t i = 0; i < n; i++)
+                {
+                    if (charClasses[static_cast<unsigned char>(data[i])] & mask)
+                        bits |= uint64_t(1) << i;
+                }
+                return bits;
+            }
+
+            uint64_t classBits64(const char* data, unsigned mask)
+            {
+                return classBits(data, 64, mask);
+            }
+
+            size_t find(const char* data, size_t pos, size_t size, unsigned mask)
+            {
+                for (; pos < size; pos++)
+                {
+                    if (charClasses[static_cast<unsigned char>(data[pos])] & mask)
+                        return pos;
+                }
+                return size;
+            }
+
+            size_t search(const char* data, size_t pos, size_t size, const char* pattern, size_t length)
+            {
+                size_t index = std::string_view(data, size).find(std::string_view(pattern, length), pos);
+                return index == std::string_view::npos ? size : index;
+            }
+
+            int compareFolded(const char* lhs, const char* rhs, size_t n)
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    unsigned char x = foldCase(lhs[i]), y = foldCase(rhs[i]);
+                    if (x != y)
+                        return x < y ? -1 : 1;
+                }
+                return 0;
+            }
+
+            const ScanKernels scanKernels = { classBits64, find, search, compareFolded };
+
+            void add(const double* lhs, const double* rhs, double* out, size_t n)
+            {
+                for (size_t i = 0; i < n; i++)
+                    out[i] = lhs[i] + rhs[i];
+            }
+
+            void scale(const double* in, double factor, double* out, size_t n)
+            {
+                for (size_t i = 0; i < n; i++)
+                    out[i] = in[i] * factor;
+            }
+
+            double dot(const double* lhs, const double* rhs, size_t n)
+            {
+                double result = 0;
+                for (size_t i = 0; i < n; i++)
+                    result += lhs[i] * rhs[i];
+                return result;
+            }
+
+            double sum(const double* in, size_t n)
+            {
+                double result = 0;
+                for (size_t i = 0; i < n; i++)
+                    result += in[i];
+                return result;
+            }
+
+            double min(const double* in, size_t n)
+            {
+                double result = in[0];
+                for (size_t i = 1; i < n; i++)
+                    result = std::min(result, in[i]);
+                return result;
+            }
+
+            double max(const double* in, size_t n)
+            {
+                double result = in[0];
+                for (size_t i = 1; i < n; i++)
+                    result = std::max(result, in[i]);
+                return result;
+            }
+
+            // No kernel: Simd::map's own loop is the scalar version.
+            bool map(UnaryOp, const double*, double*, size_t)
+            {
+                return false;
+            }
+
+            void axpy(double a, const double* x, double* y, size_t n)
+            {
+                for (size_t i = 0; i < n; i++)
+                    y[i] += a * x[i];
+            }
+
+            template<void (*Axpy)(double, const double*, double*, size_t)>
+            void gemmBlock(const double* a, const double* b, double* c, size_t rows, size_t depth, size_t width, size_t lda, size_t ldb, size_t ldc)
+            {
+                for (size_t i = 0; i < rows; i++)
+                    for (size_t p = 0; p < depth; p++)
+                        Axpy(a[i * lda + p], b + p * ldb, c + i * ldc, width);
+            }
+
+            const Kernels kernels = { add, scale, dot, sum, min, max, map, axpy, gemmBlock<axpy> };
+        }
+
+#ifdef MINI_LISP_X86
+        namespace SSE2
+        {
+            double horizontalSum(__m128d v)
+            {
+                return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+            }
+
+            void add(const double* lhs, const double* rhs, double* out, size_t n)
+            {
+                size_t i = 0;
+                for (; i + 2 <= n; i += 2)
+                    _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+                Scalar::add(lhs + i, rhs + i, out + i, n - i);
+            }
+
+            void scale(const double* in, double factor, double* out, size_t n)
+            {
+                __m128d k = _mm_set1_pd(factor);
+                size_t i = 0;
+                for (; i + 2 <= n; i += 2)
+                    _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(in + i), k));
+                Scalar::scale(in + i, factor, out + i, n - i);
+            }
+
+            double dot(const double* lhs, const double* rhs, size_t n)
+            {
+                __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4)
+                {
+                    acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+                    acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(lhs + i + 2), _mm_loadu_pd(rhs + i + 2)));
+                }
+                return horizontalSum(_mm_add_pd(acc0, acc1)) + Scalar::dot(lhs + i, rhs + i, n - i);
+            }
+
+            double sum(const double* in, size_t n)
+            {
+                __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4)
+                {
+                    acc0 = _mm_add_pd(acc0, _mm_loadu_pd(in + i));
+                    acc1 = _mm_add_pd(acc1, _mm_loadu_pd(in + i + 2));
+                }
+                return horizontalSum(_mm_add_pd(acc0, acc1)) + Scalar::sum(in + i, n - i);
+            }
+
+            double min(const double* in, size_t n)
+            {
+                if (n < 2)
+                    return Scalar::min(in, n);
+                __m128d acc = _mm_loadu_pd(in);
+                size_t i = 2;
+                for (; i + 2 <= n; i += 2)
+                    acc = _mm_min_pd(acc, _mm_loadu_pd(in + i));
+                double result = std::min(_mm_cvtsd_f64(acc), _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)));
+                for (; i < n; i++)
+                    result = std::min(result, in[i]);
+                return result;
+            }
+
+            double max(const double* in, size_t n)
+            {
+                if (n < 2)
+                    return Scalar::max(in, n);
+                __m128d acc = _mm_loadu_pd(in);
+                size_t i = 2;
+                for (; i + 2 <= n; i += 2)
+                    acc = _mm_max_pd(acc, _mm_loadu_pd(in + i));
+                double result = std::max(_mm_cvtsd_f64(acc), _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)));
+                for (; i < n; i++)
+                    result = std::max(result, in[i]);
+                return result;
+            }
+
+            bool map(UnaryOp op, const double* in, double* out, size_t n)
+            {
+                const __m128d signMask = _mm_set1_pd(-0.0);
+                size_t i = 0;
+                switch (op)
+                {
+                case UnaryOp::Abs:
+                    for (; i + 2 <= n; i += 2)
+                        _mm_storeu_pd(out + i, _mm_andnot_pd(signMask, _mm_loadu_pd(in + i)));
+                    break;
+                case UnaryOp::Negate:
+                    for (; i + 2 <= n; i += 2)
+                        _mm_storeu_pd(out + i, _mm_xor_pd(signMask, _mm_loadu_pd(in + i)));
+                    break;
+                case UnaryOp::Square:
+                    for (; i + 2 <= n; i += 2)
+                    {
+                        __m128d x = _mm_loadu_pd(in + i);
+                        _mm_storeu_pd(out + i, _mm_mul_pd(x, x));
+                    }
+                    break;
+                case UnaryOp::Sqrt:
+                    for (; i + 2 <= n; i += 2)
+                        _mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_loadu_pd(in + i)));
+                    break;
+                default:
+                    return false;
+                }
+                for (; i < n; i++)
+                    out[i] = scalarApply(op, in[i]);
+                return true;
+            }
+
+            void axpy(double a, const double* x, double* y, size_t n)
+            {
+                __m128d k = _mm_set1_pd(a);
+                size_t i = 0;
+                for (; i + 2 <= n; i += 2)
+                    _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(k, _mm_loadu_pd(x + i))));
+                Scalar::axpy(a, x + i, y + i, n - i);
+            }
+
+            // Byte-wise class membership of 16 bytes at once, as 0xFF/0x00 lanes.
+            SIMD_INLINE __m128i classify(__m128i x, unsigned mask)
+            {
+                __m128i result = _mm_setzero_si128();
+                if (mask & Whitespace)
+                {
+                    // ' ' or '\t'..'\r': x - 9 <= 4 as unsigned bytes.
+                    __m128i offset = _mm_sub_epi8(x, _mm_set1_epi8(9));
+                    result = _mm_or_si128(result, _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(4)), offset));
+                    result = _mm_or_si128(result, _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+                }
+                if (mask & Delimiter)
+                {
+                    for (char c : { '(', ')', '\'', '`', ',', '"' })
+                        result = _mm_or_si128(result, _mm_cmpeq_epi8(x, _mm_set1_epi8(c)));
+                }
+                if (mask & Quote)
+                    result = _mm_or_si128(result, _mm_cmpeq_epi8(x, _mm_set1_epi8('"')));
+                if (mask & Backslash)
+                    result = _mm_or_si128(result, _mm_cmpeq_epi8(x, _mm_set1_epi8('\\')));
+                if (mask & Newline)
+                    result = _mm_or_si128(result, _mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+                return result;
+            }
+
+            uint64_t classBits(const char* data, unsigned mask)
+            {
+                uint64_t bits = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i));
+                    bits |= uint64_t(static_cast<unsigned>(_mm_movemask_epi8(classify(block, mask)))) << (16 * i);
+                }
+                return bits;
+            }
+
+            size_t find(const char* data, size_t pos, size_t size, unsigned mask)
+            {
+                for (; pos + 16 <= size; pos += 16)
+                {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+                    unsigned hits = static_cast<unsigned>(_mm_movemask_epi8(classify(block, mask)));
+                    if (hits)
+                        return pos + std::countr_zero(hits);
+                }
+                return Scalar::find(data, pos, size, mask);
+            }
+
+            // Candidates are the positions where the first and the last byte of pattern both match,
+            // 16 at a time; only those are compared in full. length is at least 2.
+            size_t search(const char* data, size_t pos, size_t size, const char* pattern, size_t length)
+            {
+                __m128i first = _mm_set1_epi8(pattern[0]);
+                __m128i last = _mm_set1_epi8(pattern[length - 1]);
+                for (; pos + length - 1 + 16 <= size; pos += 16)
+                {
+                    __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+                    __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + length - 1));
+                    unsigned hits = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))));
+                    for (; hits; hits &= hits - 1)
+                    {
+                        size_t candidate = pos + std::countr_zero(hits);
+                        if (std::memcmp(data + candidate + 1, pattern + 1, length - 2) == 0)
+                            return candidate;
+                    }
+                }
+                return Scalar::search(data, pos, size, pattern, length);
+            }
+
+            // ASCII upper case letters of x in lower case: 'A'..'Z' are the bytes with x - 'A' <= 25 as
+            // unsigned, and get bit 5 set.
+            SIMD_INLINE __m128i foldCase(__m128i x)
+            {
+                __m128i offset = _mm_sub_epi8(x, _mm_set1_epi8('A'));
+                __m128i isUpper = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(25)), offset);
+                return _mm_or_si128(x, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+            }
+
+            int compareFolded(const char* lhs, const char* rhs, size_t n)
+            {
+                size_t i = 0;
+                for (; i + 16 <= n; i += 16)
+                {
+                    __m128i x = foldCase(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i)));
+                    __m128i y = foldCase(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i)));
+                    unsigned same = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+                    if (same != 0xFFFF)
+                    {
+                        size_t j = i + std::countr_zero(~same);
+                        return Scalar::compareFolded(lhs + j, rhs + j, 1);
+                    }
+                }
+                return Scalar::compareFolded(lhs + i, rhs + i, n - i);
+            }
+
+            const ScanKernels scanKernels = { classBits, find, search, compareFolded };
+
+            const Kernels kernels = { add, scale, dot, sum, min, max, map, axpy, Scalar::gemmBlock<axpy> };
+        }
+
+        namespace AVX
+        {
+            SIMD_TARGET_AVX double horizontalSum(__m256d v)
+            {
+                __m128d low = _mm256_castpd256_pd128(v);
+                __m128d high = _mm256_extractf128_pd(v, 1);
+                return SSE2::horizontalSum(_mm_add_pd(low, high));
+            }
+
+            SIMD_TARGET_AVX void add(const double* lhs, const double* rhs, double* out, size_t n)
+            {
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4)
+                    _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i)));
+                Scalar::add(lhs + i, rhs + i, out + i, n - i);
+            }
+
+            SIMD_TARGET_AVX void scale(const double* in, double factor, double* out, size_t n)
+            {
+                __m256d k = _mm256_set1_pd(factor);
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4)
+                    _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(in + i), k));
+                Scalar::scale(in + i, factor, out + i, n - i);
+            }
+
+            SIMD_TARGET_AVX double dot(const double* lhs, const double* rhs, size_t n)
+            {
+                __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8)
+                {
+                    acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i)));
+                    acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(lhs + i + 4), _mm256_loadu_pd(rhs + i + 4)));
+                }
+                return horizontalSum(_mm256_add_pd(acc0, acc1)) + Scalar::dot(lhs + i, rhs + i, n - i);
+            }
+
+            SIMD_TARGET_AVX double sum(const double* in, size_t n)
+            {
+                __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8)
+                {
+                    acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(in + i));
+                    acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(in + i + 4));
+                }
+                return horizontalSum(_mm256_add_pd(acc0, acc1)) + Scalar::sum(in + i, n - i);
+            }
+
+            SIMD_TARGET_AVX double min(const double* in, size_t n)
+            {
+                if (n < 4)
+                    return SSE2::min(in, n);
+                __m256d acc = _mm256_loadu_pd(in);
+                size_t i = 4;
+                for (; i + 4 <= n; i += 4)
+                    acc = _mm256_min_pd(acc, _mm256_loadu_pd(in + i));
+                __m128d half = _mm_min_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+                double result = std::min(_mm_cvtsd_f64(half), _mm_cvtsd_f64(_mm_unpackhi_pd(half, half)));
+                for (; i < n; i++)
+                    result = std::min(result, in[i]);
+                return result;
+            }
+
+            SIMD_TARGET_AVX double max(const double* in, size_t n)
+            {
+                if (n < 4)
+                    return SSE2::max(in, n);
+                __m256d acc = _mm256_loadu_pd(in);
+                size_t i = 4;
+                for (; i + 4 <= n; i += 4)
+                    acc = _mm256_max_pd(acc, _mm256_loadu_pd(in + i));
+                __m128d half = _mm_max_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+                double result = std::max(_mm_cvtsd_f64(half), _mm_cvtsd_f64(_mm_unpackhi_pd(half, half)));
+                for (; i < n; i++)
+                    result = std::max(result, in[i]);
+                return result;
+            }
+
+            SIMD_TARGET_AVX bool map(UnaryOp op, const double* in, double* out, size_t n)
+            {
+                const __m256d signMask = _mm256_set1_pd(-0.0);
+                size_t i = 0;
+                switch (op)
+                {
+                case UnaryOp::Abs:
+                    for (; i + 4 <= n; i += 4)
+                        _mm256_storeu_pd(out + i, _mm256_andnot_pd(signMask, _mm256_loadu_pd(in + i)));
+                    break;
+                case UnaryOp::Negate:
+                    for (; i + 4 <= n; i += 4)
+                        _mm256_storeu_pd(out + i, _mm256_xor_pd(signMask, _mm256_loadu_pd(in + i)));
+                    break;
+                case UnaryOp::Square:
+                    for (; i + 4 <= n; i += 4)
+                    {
+                        __m256d x = _mm256_loadu_pd(in + i);
+                        _mm256_storeu_pd(out + i, _mm256_mul_pd(x, x));
+                    }
+                    break;
+                case UnaryOp::Sqrt:
+                    for (; i + 4 <= n; i += 4)
+                        _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_loadu_pd(in + i)));
+                    break;
+                case UnaryOp::Floor:
+                    for (; i + 4 <= n; i += 4)
+                        _mm256_storeu_pd(out + i, _mm256_floor_pd(_mm256_loadu_pd(in + i)));
+                    break;
+                case UnaryOp::Ceiling:
+                    for (; i + 4 <= n; i += 4)
+                        _mm256_storeu_pd(out + i, _mm256_ceil_pd(_mm256_loadu_pd(in + i)));
+                    break;
+                case UnaryOp::Round:
+                    for (; i + 4 <= n; i += 4)
+                        _mm256_storeu_pd(out + i, _mm256_round_pd(_mm256_loadu_pd(in + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+                    break;
+                default:
+                    return false;
+                }
+                for (; i < n; i++)
+                    out[i] = scalarApply(op, in[i]);
+                return true;
+            }
+
+            SIMD_TARGET_AVX void axpy(double a, const double* x, double* y, size_t n)
+            {
+                __m256d k = _mm256_set1_pd(a);
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8)
+                {
+                    _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_mul_pd(k, _mm256_loadu_pd(x + i))));
+                    _mm256_storeu_pd(y + i + 4, _mm256_add_pd(_mm256_loadu_pd(y + i + 4), _mm256_mul_pd(k, _mm256_loadu_pd(x + i + 4))));
+                }
+                Scalar::axpy(a, x + i, y + i, n - i);
+            }
+
+            // 4x8 register tile: keeps eight accumulators in ymm registers across the whole depth.
+            SIMD_TARGET_AVX void gemmTile(const double* a, const double* b, double* c, size_t depth, size_t lda, size_t ldb, size_t ldc)
+            {
+                __m256d c00 = _mm256_loadu_pd(c), c01 = _mm256_loadu_pd(c + 4);
+                __m256d c10 = _mm256_loadu_pd(c + ldc), c11 = _mm256_loadu_pd(c + ldc + 4);
+                __m256d c20 = _mm256_loadu_pd(c + 2 * ldc), c21 = _mm256_loadu_pd(c + 2 * ldc + 4);
+                __m256d c30 = _mm256_loadu_pd(c + 3 * ldc), c31 = _mm256_loadu_pd(c + 3 * ldc + 4);
+                for (size_t p = 0; p < depth; p++)
+                {
+                    __m256d b0 = _mm256_loadu_pd(b + p * ldb), b1 = _mm256_loadu_pd(b + p * ldb + 4);
+                    __m256d a0 = _mm256_broadcast_sd(a + p);
+                    c00 = _mm256_add_pd(c00, _mm256_mul_pd(a0, b0));
+                    c01 = _mm256_add_pd(c01, _mm256_mul_pd(a0, b1));
+                    __m256d a1 = _mm256_broadcast_sd(a + lda + p);
+                    c10 = _mm256_add_pd(c10, _mm256_mul_pd(a1, b0));
+                    c11 = _mm256_add_pd(c11, _mm256_mul_pd(a1, b1));
+                    __m256d a2 = _mm256_broadcast_sd(a + 2 * lda + p);
+                    c20 = _mm256_add_pd(c20, _mm256_mul_pd(a2, b0));
+                    c21 = _mm256_add_pd(c21, _mm256_mul_pd(a2, b1));
+                    __m256d a3 = _mm256_broadcast_sd(a + 3 * lda + p);
+                    c30 = _mm256_add_pd(c30, _mm256_mul_pd(a3, b0));
+                    c31 = _mm256_add_pd(c31, _mm256_mul_pd(a3, b1));
+                }
+                _mm256_storeu_pd(c, c00), _mm256_storeu_pd(c + 4, c01);
+                _mm256_storeu_pd(c + ldc, c10), _mm256_storeu_pd(c + ldc + 4, c11);
+                _mm256_storeu_pd(c + 2 * ldc, c20), _mm256_storeu_pd(c + 2 * ldc + 4, c21);
+                _mm256_storeu_pd(c + 3 * ldc, c30), _mm256_storeu_pd(c + 3 * ldc + 4, c31);
+            }
+
+            SIMD_TARGET_AVX void gemmBlock(const double* a, const double* b, double* c, size_t rows, size_t depth, size_t width, size_t lda, size_t ldb, size_t ldc)
+            {
+                size_t tiledRows = rows / 4 * 4, tiledWidth = width / 8 * 8;
+                for (size_t i = 0; i < tiledRows; i += 4)
+                    for (size_t j = 0; j < tiledWidth; j += 8)
+                        gemmTile(a + i * lda, b + j, c + i * ldc + j, depth, lda, ldb, ldc);
+                if (tiledWidth < width)
+                    Scalar::gemmBlock<axpy>(a, b + tiledWidth, c + tiledWidth, tiledRows, depth, width - tiledWidth, lda, ldb, ldc);
+                if (tiledRows < rows)
+                    Scalar::gemmBlock<axpy>(a + tiledRows * lda, b, c + tiledRows * ldc, rows - tiledRows, depth, width, lda, ldb, ldc);
+            }
+
+            const Kernels kernels = { add, scale, dot, sum, min, max, map, axpy, gemmBlock };
+        }
+
+        namespace AVX2
+        {
+            SIMD_TARGET_AVX2 SIMD_INLINE __m256i classify(__m256i x, unsigned mask)
+            {
+                __m256i result = _mm256_setzero_si256();
+                if (mask & Whitespace)
+                {
+                    __m256i offset = _mm256_sub_epi8(x, _mm256_set1_epi8(9));
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(4)), offset));
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+                }
+                if (mask & Delimiter)
+                {
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('(')));
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(')')));
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\'')));
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('`')));
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(',')));
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('"')));
+                }
+                if (mask & Quote)
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('"')));
+                if (mask & Backslash)
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\')));
+                if (mask & Newline)
+                    result = _mm256_or_si256(result, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')));
+                return result;
+            }
+
+            SIMD_TARGET_AVX2 uint64_t classBits(const char* data, unsigned mask)
+            {
+                __m256i low = classify(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)), mask);
+                __m256i high = classify(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32)), mask);
+                return uint64_t(static_cast<unsigned>(_mm256_movemask_epi8(low)))
+                    | uint64_t(static_cast<unsigned>(_mm256_movemask_epi8(high))) << 32;
+            }
+
+            SIMD_TARGET_AVX2 size_t find(const char* data, size_t pos, size_t size, unsigned mask)
+            {
+                for (; pos + 32 <= size; pos += 32)
+                {
+                    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+                    unsigned hits = static_cast<unsigned>(_mm256_movemask_epi8(classify(block, mask)));
+                    if (hits)
+                        return pos + std::countr_zero(hits);
+                }
+                return SSE2::find(data, pos, size, mask);
+            }
+
+            SIMD_TARGET_AVX2 size_t search(const char* data, size_t pos, size_t size, const char* pattern, size_t length)
+            {
+                __m256i first = _mm256_set1_epi8(pattern[0]);
+                __m256i last = _mm256_set1_epi8(pattern[length - 1]);
+                for (; pos + length - 1 + 32 <= size; pos += 32)
+                {
+                    __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+                    __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + length - 1));
+                    unsigned hits = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last))));
+                    for (; hits; hits &= hits - 1)
+                    {
+                        size_t candidate = pos + std::countr_zero(hits);
+                        if (std::memcmp(data + candidate + 1, pattern + 1, length - 2) == 0)
+                            return candidate;
+                    }
+                }
+                return SSE2::search(data, pos, size, pattern, length);
+            }
+
+            const ScanKernels scanKernels = { classBits, find, search, SSE2::compareFolded };
+        }
+
+        bool cpuSupportsAVX2()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+        bool cpuSupportsAVX()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+            return osSavesYmm && (info[2] & (1 << 28));
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx");
+#endif
+        }
+#endif // MINI_LISP_X86
+
+        Level detectLevel()
+        {
+#ifdef MINI_LISP_X86
+            if (cpuSupportsAVX())
+                return cpuSupportsAVX2() ? Level::AVX2 : Level::AVX;
+            return Level::SSE2;
+#else
+            return Level::Scalar;
+#endif
+        }
+
+        const Kernels& kernels()
+        {
+            static const Kernels& selected = []() -> const Kernels& {
+                switch (level())
+                {
+#ifdef MINI_LISP_X86
+                case Level::AVX2:
+                case Level::AVX: return AVX::kernels;
+                case Level::SSE2: return SSE2::kernels;
+#endif
+                default: return Scalar::kernels;
+                }
+            }();
+            return selected;
+        }
+
+        const ScanKernels& scanKernels()
+        {
+            static const ScanKernels& selected = []() -> const ScanKernels& {
+                switch (level())
+                {
+#ifdef MINI_LISP_X86
+                case Level::AVX2: return AVX2::scanKernels;
+                case Level::AVX:
+                case Level::SSE2: return SSE2::scanKernels;
+#endif
+                default: return Scalar::scanKernels;
+                }
+            }();
+            return selected;
+        }
+    }
+
+    namespace
+    {
+        // Computes rows [rowBegin, rowEnd) of c, which must be zeroed.
+        void matmulRows(const double* a, const double* b, double* c, size_t rowBegin, size_t rowEnd, size_t inner, size_t cols)
+        {
+            auto gemmBlock = kernels().gemmBlock;
+            for (size_t i0 = rowBegin; i0 < rowEnd; i0 += RowBlock)
+            {
+                size_t rowCnt = std::min(RowBlock, rowEnd - i0);
+                for (size_t p0 = 0; p0 < inner; p0 += InnerBlock)
+                {
+                    size_t depth = std::min(InnerBlock, inner - p0);
+                    for (size_t j0 = 0; j0 < cols; j0 += ColBlock)
+                    {
+                        size_t width = std::min(ColBlock, cols - j0);
+                        gemmBlock(a + i0 * inner + p0, b + p0 * cols + j0, c + i0 * cols + j0, rowCnt, depth, width, inner, cols, cols);
+                    }
+                }
+            }
+        }
+    }
+
+    Level level()
+    {
+        static const Level detected = detectLevel();
+        return detected;
+    }
+
+    void add(const double* lhs, const double* rhs, double* out, size_t n)
+    {
+        kernels().add(lhs, rhs, out, n);
+    }
+
+    void scale(const double* in, double factor, double* out, size_t n)
+    {
+        kernels().scale(in, factor, out, n);
+    }
+
+    double dot(const double* lhs, const double* rhs, size_t n)
+    {
+        return kernels().dot(lhs, rhs, n);
+    }
+
+    double sum(const double* in, size_t n)
+    {
+        return kernels().sum(in, n);
+    }
+
+    double min(const double* in, size_t n)
+    {
+        return kernels().min(in, n);
+    }
+
+    double max(const double* in, size_t n)
+    {
+        return kernels().max(in, n);
+    }
+
+    void map(UnaryOp op, const double* in, double* out, size_t n)
+    {
+        if (kernels().map(op, in, out, n))
+            return;
+        for (size_t i = 0; i < n; i++)
+            out[i] = scalarApply(op, in[i]);
+    }
+
+    void axpy(double a, const double* x, double* y, size_t n)
+    {
+        kernels().axpy(a, x, y, n);
+    }
+
+    void matmul(const double* a, const double* b, double* c, size_t rows, size_t inner, size_t cols)
+    {
+        std::fill(c, c + rows * cols, 0.0);
+        size_t rowBlocks = (rows + RowBlock - 1) / RowBlock;
+        size_t threadCount = std::min<size_t>(std::thread::hardware_concurrency(), rowBlocks);
+        if (threadCount <= 1 || rows * inner * cols < ParallelThreshold)
+        {
+            matmulRows(a, b, c, 0, rows, inner, cols);
+            return;
+        }
+        std::vector<std::thread> workers;
+        size_t blocksPerThread = (rowBlocks + threadCount - 1) / threadCount;
+        for (size_t t = 0; t < threadCount; t++)
+        {
+            size_t rowBegin = t * blocksPerThread * RowBlock;
+            size_t rowEnd = std::min(rows, rowBegin + blocksPerThread * RowBlock);
+            if (rowBegin >= rowEnd)
+                break;
+            workers.emplace_back(matmulRows, a, b, c, rowBegin, rowEnd, inner, cols);
+        }
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    void transpose(const double* in, double* out, size_t rows, size_t cols)
+    {
+        for (size_t i0 = 0; i0 < rows; i0 += TransposeBlock)
+        {
+            size_t i1 = std::min(i0 + TransposeBlock, rows);
+            for (size_t j0 = 0; j0 < cols; j0 += TransposeBlock)
+            {
+                size_t j1 = std::min(j0 + TransposeBlock, cols);
+                for (size_t i = i0; i < i1; i++)
+                    for (size_t j = j0; j < j1; j++)
+                        out[j * rows + i] = in[i * cols + j];
+            }
+        }
+    }
+
+    uint64_t classBits(const char* data, size_t n, unsigned mask)
+    {
+        if (n < 64)
+            return Scalar::classBits(data, n, mask);
+        return scanKernels().classBits(data, mask);
+    }
+
+    size_t findClass(const char* data, size_t pos, size_t size, unsigned mask)
+    {
+        return scanKernels().find(data, pos, size, mask);
+    }
+
+    size_t search(const char* data, size_t pos, size_t size, const char* pattern, size_t length)
+    {
+        if (length > size || pos > size - length)
+            return size;
+        if (length == 0)
+            return pos;
+        if (length == 1)
+        {
+            auto found = static_cast<const char*>(std::memchr(data + pos, pattern[0], size - pos));
+            return found ? found - data : size;
+        }
+        return scanKernels().search(data, pos, size, pattern, length);
+    }
+
+    int compareFolded(const char* lhs, const char* rhs, size_t n)
+    {
+        return scanKernels().compareFolded(lhs, rhs, n);
+    }
+}
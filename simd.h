@@ -0,0 +1,83 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MINI_LISP_X86
+#endif
+
+namespace Simd
+{
+    enum class Level
+    {
+        Scalar,
+        SSE2,
+        AVX,
+        AVX2
+    };
+
+    enum class UnaryOp
+    {
+        Abs,
+        Negate,
+        Square,
+        Sqrt,
+        Floor,
+        Ceiling,
+        Round,
+        Exp,
+        Log,
+        Sin,
+        Cos
+    };
+
+    // Highest instruction set usable on this machine, detected once at first call.
+    Level level();
+
+    void add(const double* lhs, const double* rhs, double* out, size_t n);
+    void scale(const double* in, double factor, double* out, size_t n);
+    double dot(const double* lhs, const double* rhs, size_t n);
+    double sum(const double* in, size_t n);
+    double min(const double* in, size_t n);
+    double max(const double* in, size_t n);
+    void map(UnaryOp op, const double* in, double* out, size_t n);
+    // y += a * x
+    void axpy(double a, const double* x, double* y, size_t n);
+
+    // Row-major dense kernels. c (rows x cols) = a (rows x inner) * b (inner x cols).
+    void matmul(const double* a, const double* b, double* c, size_t rows, size_t inner, size_t cols);
+    void transpose(const double* in, double* out, size_t rows, size_t cols);
+
+    // Byte classes used by the lexer; combine with |.
+    enum CharClass : unsigned
+    {
+        Whitespace = 1,     // as std::isspace in the C locale
+        Delimiter = 2,      // ( ) ' ` , "
+        Quote = 4,          // "
+        Backslash = 8,
+        Newline = 16
+    };
+
+    // Bitmap of a block of n <= 64 bytes: bit i is set when the class of data[i] intersects mask.
+    // The lexer classifies each 64-byte block once and then finds token boundaries by bit scanning.
+    uint64_t classBits(const char* data, size_t n, unsigned mask);
+    // Index of the first byte in [pos, size) whose class intersects mask, or size if there is none.
+    // Meant for long runs such as string bodies and comments.
+    size_t findClass(const char* data, size_t pos, size_t size, unsigned mask);
+    // Index of the first occurrence of pattern[0, length) in data[pos, size), or size if there is none.
+    // Candidates are found a block at a time by matching the first and the last byte of pattern.
+    size_t search(const char* data, size_t pos, size_t size, const char* pattern, size_t length);
+
+    // c with the ASCII upper case letters mapped to lower case, as std::tolower does in the C locale.
+    constexpr char foldCase(char c)
+    {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    // Compares n bytes of lhs and rhs as memcmp does, but as foldCase maps them: negative, zero or
+    // positive. Folds a block at a time, without a copy.
+    int compareFolded(const char* lhs, const char* rhs, size_t n);
+}
+
+#endif // !SIMD_H
@@ -1,16 +1,12 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
-#include <memory>
-#include <optional>
+#include <cstdint>
 #include <ostream>
 #include <string>
-#include <ranges>
-#include <algorithm>
+#include <string_view>
 
-#include "./error.h"
-
-enum class TokenType 
+enum class TokenType : uint8_t
 {
     LEFT_PAREN,
     RIGHT_PAREN,
@@ -27,124 +23,18 @@ enum class TokenType
     IDENTIFIER,
 };
 
-struct TokenMetaData
-{
-    std::shared_ptr<std::string> originalString = nullptr;
-    size_t startPos = 0;
-    size_t endPos = 0;
-};
-
-class Token;
-using TokenPtr = std::unique_ptr<Token>;
-
-class Token 
+// A lexeme as a view into the tokenizer's input, which must outlive the token.
+// Nothing is converted here: the parser turns the text into values.
+//   NUMERIC_LITERAL  the whole literal, including any #x/#b/#o/#d prefix
+//   STRING_LITERAL   the characters between the quotes, escapes not yet processed
+//   CHAR_LITERAL     the characters after the #\ prefix
+//   BOOLEAN_LITERAL  "#t" or "#f"
+struct Token
 {
-private:
     TokenType type;
-    TokenMetaData metaData;
-
-protected:
-    Token(TokenType type) : type{type} {}
-
-public:
-
-    virtual ~Token() = default;
-
-    static TokenPtr fromChar(char c);
-    static TokenPtr dot();
-    static TokenPtr unquoteSplicing();
-    static TokenPtr vectorBegin();
-
-    TokenType getType() const 
-    {
-        return type;
-    }
-    virtual std::string toString() const;
-
-    size_t metaGetStartPos() const;
-};
-
-class BooleanLiteralToken 
-    : public Token 
-{
-private:
-    bool value;
-
-public:
-    BooleanLiteralToken(bool value) : Token(TokenType::BOOLEAN_LITERAL), value{value} {}
-
-    static std::unique_ptr<BooleanLiteralToken> fromChar(char c);
-
-    bool getValue() const 
-    {
-        return value;
-    }
-    std::string toString() const override;
-};
-
-class NumericLiteralToken 
-    : public Token 
-{
-private:
-    double value;
-
-public:
-    NumericLiteralToken(double value) : Token(TokenType::NUMERIC_LITERAL), value{value} {}
-
-    double getValue() const 
-    {
-        return value;
-    }
-    std::string toString() const override;
-};
-
-class StringLiteralToken 
-    : public Token 
-{
-private:
-    std::string value;
-
-public:
-    StringLiteralToken(const std::string& value) : Token(TokenType::STRING_LITERAL), value{value} {}
-
-    const std::string& getValue() const 
-    {
-        return value;
-    }
-    std::string toString() const override;
-};
-
-class CharLiteralToken
-    :public Token
-{
-private:
-    char value;
-public:
-    CharLiteralToken(char value) :Token(TokenType::CHAR_LITERAL), value{ value } {}
-
-    static TokenPtr fromString(const std::string& s);
-
-    char getValue() const
-    {
-        return value;
-    }
-    std::string toString() const override;
-};
-
-class IdentifierToken 
-    : public Token 
-{
-private:
-    std::string name;
-
-public:
-    IdentifierToken(const std::string& name) : Token(TokenType::IDENTIFIER), name{name} {}
+    std::string_view text;
 
-    const std::string& getName() const 
-    {
-        return name;
-    }
-    std::string toString() const override;
+    std::string toString() const;
 };
 
 std::ostream& operator<<(std::ostream& os, const Token& token);
@@ -1,62 +1,95 @@
 #include "./tokenizer.h"
 
+#include <algorithm>
 #include <cctype>
-#include <set>
-#include <stdexcept>
 
 #include "./error.h"
+#include "./number.h"
+#include "./simd.h"
 
-const std::set<char> TOKEN_END{'(', ')', '\'', '`', ',', '"'};
+static std::optional<TokenType> punctuation(char c)
+{
+    switch (c)
+    {
+    case '(': return TokenType::LEFT_PAREN;
+    case ')': return TokenType::RIGHT_PAREN;
+    case '\'': return TokenType::QUOTE;
+    case '`': return TokenType::QUASIQUOTE;
+    case ',': return TokenType::UNQUOTE;
+    // DOT not listed here, because it can be part of identifier/literal.
+    default: return std::nullopt;
+    }
+}
+
+static int radixPrefix(char c)
+{
+    switch (c)
+    {
+    case 'x': case 'X': return 16;
+    case 'b': case 'B': return 2;
+    case 'o': case 'O': return 8;
+    case 'd': case 'D': return 10;
+    default: return 0;
+    }
+}
 
-TokenPtr Tokenizer::nextToken(int& pos) 
+std::optional<Token> Tokenizer::nextToken(size_t& pos) 
 {
-    std::string& input = *pInput;
-    TokenMetaData metaData = { pInput,pos,pos };
+    auto lexeme = [this](TokenType type, size_t start, size_t end) {
+        return Token{ type, input.substr(start, end - start) };
+    };
+    auto findClass = [this](size_t from, unsigned mask) {
+        return Simd::findClass(input.data(), std::min(from, input.size()), input.size(), mask);
+    };
     while (pos < input.size()) 
     {
-        metaData.startPos = pos;
+        size_t start = pos;
         auto c = input[pos];
         if (c == ';') 
         {
-            while (pos < input.size() && input[pos] != '\n') 
-            {
-                pos++;
-            }
+            pos = findClass(pos, Simd::Newline);
         } 
-        else if (std::isspace(c)) 
+        else if (std::isspace(static_cast<unsigned char>(c))) 
         {
-            pos++;
+            pos = skipWhitespace(pos);
         } 
-        else if (c == ',' && input[pos + 1] == '@')
+        else if (c == ',' && pos + 1 < input.size() && input[pos + 1] == '@')
         {
             pos += 2;
-            return Token::unquoteSplicing();
+            return lexeme(TokenType::UNQUOTE_SPLICING, start, pos);
         }
-        else if (auto token = Token::fromChar(c)) 
+        else if (auto type = punctuation(c)) 
         {
             pos++;
-            return token;
+            return lexeme(*type, start, pos);
         } 
         else if (c == '#') 
         {
-            if (auto result = BooleanLiteralToken::fromChar(input[pos + 1])) 
+            char next = pos + 1 < input.size() ? input[pos + 1] : '\0';
+            if (next == 't' || next == 'f') 
             {
                 pos += 2;
-                return result;
+                return lexeme(TokenType::BOOLEAN_LITERAL, start, pos);
             } 
-            else if (input[pos + 1] == '\\')
+            else if (next == '\\')
             {
-                std::string charExpression;
-                for (pos += 2; pos < input.size() && !std::isspace(input[pos]); pos++)
-                {
-                    charExpression += input[pos];
-                }
-                return CharLiteralToken::fromString(charExpression);
+                // The first character is always part of the literal, so #\( and #\) work.
+                pos = nextTokenEnd(start + 3);
+                return lexeme(TokenType::CHAR_LITERAL, start + 2, pos);
             }
-            else if (input[pos + 1] == '(')
+            else if (next == '(')
             {
                 pos += 2;
-                return Token::vectorBegin();
+                return lexeme(TokenType::VECTOR_BEGIN, start, pos);
+            }
+            else if (radixPrefix(next))
+            {
+                pos = nextTokenEnd(start + 2);
+                if (!Number::isLiteral(input.substr(start, pos - start)))
+                {
+                    throw SyntaxError("Invalid numeric literal " + std::string(input.substr(start, pos - start)));
+                }
+                return lexeme(TokenType::NUMERIC_LITERAL, start, pos);
             }
             else
             {
@@ -65,82 +98,59 @@ TokenPtr Tokenizer::nextToken(int& pos)
         } 
         else if (c == '"') 
         {
-            std::string string;
-            pos++;
-            while (pos < input.size()) 
+            constexpr unsigned StringSpecial = Simd::Quote | Simd::Backslash;
+            // Stops only at quotes and backslashes; a backslash skips the character it escapes.
+            for (pos = findClass(pos + 1, StringSpecial); pos < input.size(); pos = findClass(pos + 2, StringSpecial)) 
             {
                 if (input[pos] == '"') 
                 {
                     pos++;
-                    return std::make_unique<StringLiteralToken>(string);
-                } 
-                else if (input[pos] == '\\') 
-                {
-                    if (pos + 1 >= input.size()) 
-                    {
-                        throw SyntaxError("Unexpected end of string literal");
-                    }
-                    auto next = input[pos + 1];
-                    if (next == 'n') 
-                    {
-                        string += '\n';
-                    } 
-                    else 
-                    {
-                        string += next;
-                    }
-                    pos += 2;
+                    return lexeme(TokenType::STRING_LITERAL, start + 1, pos - 1);
                 } 
-                else 
-                {
-                    string += input[pos];
-                    pos++;
-                }
             }
             throw SyntaxError("Unexpected end of string literal");
         } 
         else 
         {
-            int start = pos;
-            do 
-            {
-                pos++;
-            } while (pos < input.size() && !std::isspace(input[pos]) &&
-                     !TOKEN_END.contains(input[pos]));
+            pos = nextTokenEnd(pos + 1);
             auto text = input.substr(start, pos - start);
             if (text == ".") 
             {
-                return Token::dot();
+                return lexeme(TokenType::DOT, start, pos);
             }
-            if (std::isdigit(text[0]) || text[0] == '+' || text[0] == '-' || text[0] == '.') 
+            if (std::isdigit(static_cast<unsigned char>(text[0])) || text[0] == '+' || text[0] == '-' || text[0] == '.') 
             {
-                try 
-                {
-                    return std::make_unique<NumericLiteralToken>(std::stod(text));
-                } 
-                catch (std::invalid_argument& e) 
+                if (Number::isLiteral(text))
                 {
+                    return lexeme(TokenType::NUMERIC_LITERAL, start, pos);
                 }
             }
-            return std::make_unique<IdentifierToken>(text);
+            return lexeme(TokenType::IDENTIFIER, start, pos);
         }
     }
-    return nullptr;
+    return std::nullopt;
 }
 
-std::deque<TokenPtr> Tokenizer::tokenize() {
-    std::deque<TokenPtr> tokens;
-    int pos = 0;
-    while (true) {
-        auto token = nextToken(pos);
-        if (!token) {
-            break;
-        }
-        tokens.push_back(std::move(token));
-    }
-    return tokens;
+void Tokenizer::loadBlock(size_t start)
+{
+    size_t n = std::min<size_t>(64, input.size() - start);
+    uint64_t whitespace = Simd::classBits(input.data() + start, n, Simd::Whitespace);
+    blockStart = start;
+    tokenEndBits = whitespace | Simd::classBits(input.data() + start, n, Simd::Delimiter);
+    // Bits past the end of a short final block stay set, so a scan stops at input.size().
+    nonWhitespaceBits = ~whitespace;
 }
 
-std::deque<TokenPtr> Tokenizer::tokenize(const std::string& input) {
-    return Tokenizer(input).tokenize();
+size_t Tokenizer::scanBlocks(size_t pos, uint64_t Tokenizer::* bits)
+{
+    while (pos < input.size())
+    {
+        size_t start = pos & ~size_t(63);
+        if (start != blockStart)
+            loadBlock(start);
+        if (uint64_t candidates = (this->*bits) >> (pos - start))
+            return std::min(pos + std::countr_zero(candidates), input.size());
+        pos = start + 64;
+    }
+    return input.size();
 }
@@ -1,23 +1,50 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
-#include <deque>
-#include <string>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <string_view>
 
 #include "./token.h"
 
-class Tokenizer 
+// Produces tokens from input on demand. Tokens view into input, so it must outlive them.
+class Tokenizer
 {
 private:
-    TokenPtr nextToken(int& pos);
-    std::deque<TokenPtr> tokenize();
+    std::optional<Token> nextToken(size_t& pos);
 
-    //std::string input;
-    std::shared_ptr<std::string> pInput;
-    Tokenizer(const std::string& input) : pInput{new std::string(input)} {}
+    std::string_view input;
+    size_t current = 0;
+
+    // Class bitmaps of the 64-byte block at blockStart, computed once per block by Simd::classBits.
+    // Token boundaries are then found by bit scanning instead of testing characters one by one.
+    size_t blockStart = SIZE_MAX;
+    uint64_t tokenEndBits = 0;
+    uint64_t nonWhitespaceBits = 0;
+    void loadBlock(size_t start);
+    size_t scanBlocks(size_t pos, uint64_t Tokenizer::* bits);
+
+    // First position at or after pos whose bit in the given bitmap is set, or input.size().
+    size_t findInBlocks(size_t pos, uint64_t Tokenizer::* bits)
+    {
+        size_t start = pos & ~size_t(63);
+        if (start == blockStart)
+        {
+            if (uint64_t candidates = (this->*bits) >> (pos - start))
+                return std::min(pos + std::countr_zero(candidates), input.size());
+        }
+        return scanBlocks(pos, bits);
+    }
+    size_t nextTokenEnd(size_t pos) { return findInBlocks(pos, &Tokenizer::tokenEndBits); }
+    size_t skipWhitespace(size_t pos) { return findInBlocks(pos, &Tokenizer::nonWhitespaceBits); }
 
 public:
-    static std::deque<TokenPtr> tokenize(const std::string& input);
+    Tokenizer(std::string_view input) : input{input} {}
+
+    // The next token, or nullopt once the input is exhausted.
+    std::optional<Token> next() { return nextToken(current); }
 };
 
 #endif